@@ -0,0 +1,52 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+
+#include "transcript.h"
+
+class TranscriptTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void parse_data();
+    void parse();
+};
+
+void TranscriptTest::parse_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<int>("moves");
+    QTest::addColumn<QString>("error");
+
+    QTest::newRow("moves and result") << QStringLiteral("f5d6c3 +4") << true << 3 << QString();
+    QTest::newRow("spaces") << QStringLiteral("f5 D6 c3 -2") << true << 3 << QString();
+    QTest::newRow("no moves") << QStringLiteral("+4") << false << 0 << QStringLiteral("no moves found");
+    QTest::newRow("unfinished") << QStringLiteral("f5d6") << false << 2
+                                << QStringLiteral("game is not finished and has no result");
+    QTest::newRow("turns nothing") << QStringLiteral("a1 0") << false << 1 << QStringLiteral("illegal move 1");
+    // d3 is taken by then, but playing it again would turn d4
+    QTest::newRow("occupied square") << QStringLiteral("d3c3d3 0") << false << 3 << QStringLiteral("illegal move 3");
+}
+
+void TranscriptTest::parse()
+{
+    QFETCH(QString, line);
+    QFETCH(bool, valid);
+    QFETCH(int, moves);
+    QFETCH(QString, error);
+
+    Transcript::Game game;
+    QString message;
+    QCOMPARE(Transcript::parse(line, game, message), valid);
+    QCOMPARE(game.moves.size(), moves);
+    QCOMPARE(message, error);
+}
+
+QTEST_GUILESS_MAIN(TranscriptTest)
+
+#include "transcripttest.moc"
@@ -27,286 +27,423 @@
  * look at http://www.luthman.nu/Othello/Othello.html
  */
 
-// The class Engine produces moves from a Game object through calls to the
-// function ComputeMove().
-//
-// First of all: this is meant to be a simple example of a game playing
-// program. Not everything is done in the most clever way, particularly not
-// the way the moves are searched, but it is hopefully made in a way that makes
-// it easy to understand. The function ComputeMove2() that does all the work
-// is actually not much more than a hundred lines. Much could be done to
-// make the search faster though, I'm perfectly aware of that. Feel free
-// to experiment.
-//
-// The method used to generate the moves is called minimax tree search with
-// alpha-beta pruning to a fixed depth. In short this means that all possible
-// moves a predefined number of moves ahead are either searched or refuted
-// with a method called alpha-beta pruning. A more thorough explanation of
-// this method could be found at the world wide web at
-// https://cis.temple.edu/~ingargio/cis587/readings/alpha-beta.html
-// at the time this was written. Searching for "minimax" would also point
-// you to information on this subject. It is probably possible to understand
-// this method by reading the source code though, it is not that complicated.
+// The class Engine produces moves for a Position (two bitboards and the
+// player to move) through calls to computeMove(const Position&, bool), or
+// startComputeMove() to search on a thread of its own.  It only needs
+// QtCore, so tools can link the engine library without the game.
+//
+// The moves are found by an alpha-beta search (ComputeMove2() and
+// TryAllMoves()), with a version for each color to move and for
+// heuristic and exhaustive search, so that neither is asked again at
+// every node.  How far it looks ahead is set by the iterative deepening
+// described below (m_depth).  The moves of a position are tried in the
+// order most likely to cut the search off early: the best move stored
+// in the transposition table, the killer moves of the level, then the
+// others by their history and, far enough from the leaves, by the
+// replies they leave the opponent (see OrderMoves()).  The endgame
+// solver (SolveEndgame()) and analyze() (AnalyzeMoves()) search the
+// first move with the full window and the others with a null window,
+// and a move again only if it turns out better (principal variation
+// search).
 //
 // At every leaf node at the search tree, the resulting position is evaluated.
-// Two things are considered when evaluating a position: the number of pieces
-// of each color and at which squares the pieces are located. Pieces at the
-// corners are valuable and give a high value, and having pieces at squares
-// next to a corner is not very good and they give a lower value. In the
-// beginning of a game it is more important to have pieces on "good" squares,
-// but towards the end the total number of pieces of each color is given a
-// higher weight. Other things, like how many legal moves that can be made in a
-// position, and the number of pieces that can never be turned would probably
-// make the program stronger if they were considered in evaluating a position,
-// but that would make things more complicated (this was meant to be very
-// simple example) and would also slow down computation (considerably?).
-//
-// The member m_board[10][10]) holds the current position during the
-// computation. It is initiated at the start of ComputeMove() and
-// every move that is made during the search is made on this board. It should
-// be noted that 1 to 8 is used for the actual board, but 0 and 9 can be
-// used too (they are always empty). This is practical when turning pieces
-// when moves are made on the board. Every piece that is put on the board
-// or turned is saved in the stack m_squarestack (see class SquareStack) so
-// every move can easily be reversed after the search in a node is completed.
-//
-// The member m_bc_board[][] holds board control values for each square
-// and is initiated by a call to the function private void SetupBcBoard()
-// from Engines constructor. It is used in evaluation of positions except
-// when the game tree is searched all the way to the end of the game.
-//
-// The two members m_coord_bit[9][9] and m_neighbor_bits[9][9] are used to
-// speed up the tree search. This goes against the principle of keeping things
-// simple, but to understand the program you do not need to understand them
-// at all. They are there to make it possible to throw away moves where
-// the piece that is played is not adjacent to a piece of opposite color
-// at an early stage (because they could never be legal). It should be
-// pointed out that not all moves that pass this test are legal, there will
-// just be fewer moves that have to be tested in a more time consuming way.
+// This is done by looking at the edges, the corners and the diagonals of
+// the board: for each of them a table gives the value of every way the
+// pieces could be placed on it (see class PatternEvaluator). The tables were
+// fitted to the results of many games, so they know things like which edge
+// pieces can never be turned and when a square next to a corner gives the
+// corner away. What makes a position good is not the same in the opening as
+// close to the end, so there is a separate set of tables for each stage of
+// the game.
+//
+// The position during the computation is held in two 64 bit masks, one
+// for the pieces of the color to move and one for the opponent (see
+// bitboard.h). They are set up at the start of ComputeMove() and passed
+// down the search by value. The legal moves of a position are generated
+// for all squares at once by shifting and masking the two boards, and the
+// pieces turned by a move are computed as a single mask. Making a move is
+// then just an XOR of that mask (plus the new piece) into both boards, and
+// since every level of the search works on its own copy, taking the move
+// back again costs nothing at all.
+//
+// Many positions are reached through different move orders, so every
+// position searched is remembered in m_table (see class TranspositionTable)
+// under a Zobrist hash: the XOR of one random number per piece and square,
+// which is updated together with the bitboards when a move is made. The
+// table is kept between calls to ComputeMove(), so a position that was
+// already searched one move earlier is not searched all over again. The
+// best move stored for a position is always tried first, the others
+// after it in the order of OrderMoves().
+//
+// The search itself uses iterative deepening: first all moves are searched
+// one level deep, then two levels deep and so on, until the depth allowed by
+// the strength is reached or the time for the move is used up (see
+// STRENGTH_LIMITS). Every search tries the moves in the order of the values
+// the previous one found, which together with the transposition table
+// makes the deeper searches a lot cheaper. If the time runs out in the
+// middle of a search, the move found by the last complete one is played.
+// This keeps the time the computer needs for a move about the same on any
+// machine and in any position.
+//
+// In competitive games the opening moves are taken from an opening book
+// (see class OpeningBook) as long as the position is in it, without any
+// search at all.
+//
+// Close to the end of the game the search goes all the way to the end
+// (see StrengthLimits::solve). The positions are then no longer evaluated
+// but solved exactly by a separate, much faster endgame solver (see
+// Solve()), first only to find out whether the moves win, draw or lose
+// and then for the exact score.
+//
+// On machines with more than one core, helper engines search the same
+// position on other threads at the same time (see StartHelpers()). They
+// share the transposition table with the main search, which then finds
+// many positions already searched for it. The table can be used by all
+// threads at once without locks.
 //
 // There are also two other members that should be mentioned: Score m_score
-// and Score m_bc_score. They hold the number of pieces of each color and
-// the sum of the board control values for each color during the search
-// (this is faster than counting at every leaf node).
+// and PatternEvaluator m_patterns. They hold the number of pieces of each
+// color and the indices into the evaluation tables during the search, and
+// are updated when a move is made and taken back (this is faster than
+// looking at the whole board at every leaf node).
 //
 
-// The classes SquareStackEntry and SquareStack implement a
-// stack that is used by Engine to store pieces that are turned during
-// searching (see ComputeMove()).
-//
 // The class MoveAndValue is used by Engine to store all possible moves
 // at the first level and the values that were calculated for them.
 // This makes it possible to select a random move among those with equal
 // or nearly equal value after the search is completed.
 
 #include "Engine.h"
+#include "allocationcounter.h"
 
-#include <QApplication>
+#include <QMutex>
+#include <QtConcurrent>
+
+#include <limits>
 
 // ================================================================
-//           Classes SquareStackEntry and SquareStack
+//                       Class MoveAndValue
 
 
-// A SquareStack is used to store changes to the squares on the board
-// during search.
+// Class MoveAndValue aggregates a move with its value.
+//
 
 
-inline void SquareStackEntry::setXY(int x, int y)
+inline void MoveAndValue::setSV(int square, int value)
 {
-    m_x = x;
-    m_y = y;
+    m_square = square;
+    m_value  = value;
 }
 
 
-SquareStackEntry::SquareStackEntry()
+MoveAndValue::MoveAndValue()
 {
-    setXY(0, 0);
+    setSV(0, 0);
 }
 
 
-// ----------------------------------------------------------------
-
-
-SquareStack::SquareStack()
+MoveAndValue::MoveAndValue(int square, int value)
 {
-    init(0);
+    setSV(square, value);
 }
 
 
-SquareStack::SquareStack(int size)
+// Sort moves by less, keeping the order of moves that are equal.  There
+// are only a few of them, so insertion sort does as well as any, and
+// unlike std::stable_sort() it needs no memory of its own.
+
+template<typename Less>
+static void SortMoves(MoveAndValue *moves, int number_of_moves, Less less)
 {
-    init(size);
+    for (int i = 1; i < number_of_moves; ++i) {
+        const MoveAndValue move = moves[i];
+        int j = i;
+        for (; j > 0 && less(move, moves[j - 1]); --j)
+            moves[j] = moves[j - 1];
+        moves[j] = move;
+    }
 }
 
+// ================================================================
+//                        The Engine itself
+
+
+// Some special values used in the search.
+static const int LARGEINT      = 99999;
+static const int ILLEGAL_VALUE = 8888888;
+static const int MIN_TABLE_DEPTH = 2;
+static const int CHECK_INTERVAL = 64;
+
+// Move ordering in TryAllMoves(): the key of the killer moves, the
+// largest history a move may have and from how many levels above the
+// leaves on the moves are ordered by the replies they leave.
+static const int KILLER_KEY           = 1 << 30;
+static const int HISTORY_LIMIT        = 1 << 16;
+static const int MOBILITY_ORDER_DEPTH = 3;
+
+// Limits for the endgame solver: how many of the first levels of
+// iterative deepening are searched before the game is solved, and from
+// how many empty squares on the solver uses the transposition table and
+// the slower but better fastest-first move ordering.
+static const int PRESOLVE_DEPTH        = 4;
+static const int SOLVER_TABLE_EMPTIES  = 8;
+static const int FASTEST_FIRST_EMPTIES = 6;
+static const int SOLVER_INFINITY       = 65;
+
+// The search limits for each strength: the deepest that is searched,
+// the time in milliseconds a move may take and the number of empty
+// squares from which on the game is solved exactly.  The strength is
+// the index of the difficulty level, from very easy to impossible.  The
+// evaluation alone already plays well, so the easier levels only look
+// one move ahead.
+struct StrengthLimits {
+    int depth;
+    int msecs;
+    int solve;
+};
+
+static const StrengthLimits STRENGTH_LIMITS[] = {
+    {  1,  250,  4 },
+    {  1,  250,  4 },
+    {  1,  500,  5 },
+    {  1,  750,  6 },
+    {  2, 1000,  7 },
+    {  3, 2000, 11 },
+    { 60, 3000, 20 }
+};
+static const int MAX_STRENGTH = 6;
+
+// The random numbers used to compute the hash of a position: one for
+// each color and square, their XOR for turning a piece, and one each for
+// the side to move, for exhaustive results and for every strength.  They
+// are computed by the compiler with the splitmix64 generator from a fixed
+// seed, so every engine uses the same numbers and hashes stay comparable
+// between engines.
+struct ZobristKeys {
+    quint64 piece[2][64];
+    quint64 flip[64];
+    quint64 side;
+    quint64 exhaustive;
+    quint64 strength[MAX_STRENGTH + 1];
+};
 
-void SquareStack::resize(int size)
+static constexpr quint64 SplitMix64(quint64 &state)
 {
-    m_squarestack.resize(size);
+    quint64 z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
+static constexpr ZobristKeys MakeZobristKeys()
+{
+    ZobristKeys keys = {};
+    quint64 state = 0x4b526576;
 
-// (Re)initialize the stack so that is empty, and at the same time
-// resize it to 'size'.
-//
+    for (int color = White; color <= Black; color++)
+        for (int square = 0; square < 64; square++)
+            keys.piece[color][square] = SplitMix64(state);
 
-void SquareStack::init(int size)
-{
-    resize(size);
+    for (int square = 0; square < 64; square++)
+        keys.flip[square] = keys.piece[White][square] ^ keys.piece[Black][square];
+
+    keys.side       = SplitMix64(state);
+    keys.exhaustive = SplitMix64(state);
+    for (int strength = 0; strength <= MAX_STRENGTH; strength++)
+        keys.strength[strength] = SplitMix64(state);
 
-    m_top = 0;
-    for (int i = 0; i < size; i++)
-        m_squarestack[i].setXY(0, 0);
+    return keys;
 }
 
+static constexpr ZobristKeys ZOBRIST = MakeZobristKeys();
 
 
-inline SquareStackEntry SquareStack::Pop()
+Engine::Engine(int st, int sd)/* : SuperEngine(st, sd) */
+    : m_killers()
+    , m_history()
+    , m_strength(st)
+    , m_random(sd)
+    , m_time_limit(0)
+    , m_node_limit(0)
+    , m_depth_limit(0)
+    , m_interrupt(false)
+    , m_stop(false)
+    , m_pondering(false)
+    , m_move_value(0)
+    , m_move_depth(0)
+    , m_move_exact(false)
+    , m_computingMove(false)
 {
-    return m_squarestack[--m_top];
+    m_search_thread.setMaxThreadCount(1);
+    m_helper_threads.setMaxThreadCount(1);
 }
 
 
-inline void SquareStack::Push(int x, int y)
+Engine::Engine(int st) //: SuperEngine(st)
+    : m_killers()
+    , m_history()
+    , m_strength(st)
+    , m_random(QRandomGenerator::global()->generate())
+    , m_time_limit(0)
+    , m_node_limit(0)
+    , m_depth_limit(0)
+    , m_interrupt(false)
+    , m_stop(false)
+    , m_pondering(false)
+    , m_move_value(0)
+    , m_move_depth(0)
+    , m_move_exact(false)
+    , m_computingMove(false)
 {
-    m_squarestack[m_top].m_x = x;
-    m_squarestack[m_top++].m_y = y;
+    m_search_thread.setMaxThreadCount(1);
+    m_helper_threads.setMaxThreadCount(1);
 }
 
 
-// ================================================================
-//                       Class MoveAndValue
+Engine::Engine()// : SuperEngine(1)
+    : m_killers()
+    , m_history()
+    , m_strength(1)
+    , m_random(QRandomGenerator::global()->generate())
+    , m_time_limit(0)
+    , m_node_limit(0)
+    , m_depth_limit(0)
+    , m_interrupt(false)
+    , m_stop(false)
+    , m_pondering(false)
+    , m_move_value(0)
+    , m_move_depth(0)
+    , m_move_exact(false)
+    , m_computingMove(false)
+{
+    m_search_thread.setMaxThreadCount(1);
+    m_helper_threads.setMaxThreadCount(1);
+}
 
+Engine::~Engine()
+{
+    // A search that is still running uses our data, so stop it first.
+    setInterrupt(true);
+    m_search_thread.waitForDone();
 
-// Class MoveAndValue aggregates a move with its value.
-//
+    qDeleteAll(m_helpers);
+}
 
+// Limit the time (in milliseconds), the number of nodes searched or the
+// depth of the search for a move.  A time or depth limit of 0 means the
+// default of the current strength is used, a node limit of 0 that there
+// is none.
 
-inline void MoveAndValue::setXYV(int x, int y, int value)
+void Engine::setTimeLimit(int msecs)
 {
-    m_x     = x;
-    m_y     = y;
-    m_value = value;
+    m_time_limit = msecs;
 }
 
 
-MoveAndValue::MoveAndValue()
+void Engine::setNodeLimit(qint64 nodes)
 {
-    setXYV(0, 0, 0);
+    m_node_limit = nodes;
 }
 
 
-MoveAndValue::MoveAndValue(int x, int y, int value)
+void Engine::setDepthLimit(int depth)
 {
-    setXYV(x, y, value);
+    m_depth_limit = depth;
 }
 
-// ================================================================
-//                       class Score
 
-/* This class keeps track of the score for both colors.  Such a score
- * could be either the number of pieces, the score from the evaluation
- * function or anything similar.
- */
-class Score
+qint64 Engine::nodesSearched() const
 {
-public:
-    Score() {
-        m_score[White] = 0;
-        m_score[Black] = 0;
-    }
-
-    uint score(ChipColor color) const     {
-        return m_score[color];
-    }
+    qint64 nodes = m_nodes_searched;
+    for (const Engine *helper : m_helpers)
+        nodes += helper->m_nodes_searched;
+    return nodes;
+}
 
-    void set(ChipColor color, uint score) {
-        m_score[color] = score;
-    }
-    void inc(ChipColor color)             {
-        m_score[color]++;
-    }
-    void dec(ChipColor color)             {
-        m_score[color]--;
-    }
-    void add(ChipColor color, uint s)     {
-        m_score[color] += s;
-    }
-    void sub(ChipColor color, uint s)     {
-        m_score[color] -= s;
-    }
 
-private:
-    uint  m_score[2];
-};
-
-// ================================================================
-//                        The Engine itself
+// Use about megabytes of memory for the transposition table.  The
+// table is kept between calls to computeMove(), so this also forgets
+// everything we found out so far.
 
+void Engine::setHashTableSize(int megabytes)
+{
+    EnsureTable();
+    m_table->resize(megabytes);
+}
 
-// Some special values used in the search.
-static const int LARGEINT      = 99999;
-static const int ILLEGAL_VALUE = 8888888;
-static const int BC_WEIGHT     = 3;
 
+// Use table as the transposition table, instead of one of our own.
+// Other engines may use it at the same time, even while searching, so
+// that what one of them has found out is known to all.  Must not be
+// called while a move is being computed.  An engine that is never given
+// a table makes its own, see EnsureTable().
 
-Engine::Engine(int st, int sd)/* : SuperEngine(st, sd) */
-    : m_strength(st)
-    , m_random(sd)
-    , m_computingMove(false)
+void Engine::setTable(const QSharedPointer<TranspositionTable> &table)
 {
-    m_score = new Score;
-    m_bc_score = new Score;
-    SetupBcBoard();
-    SetupBits();
+    m_table = table;
+    for (Engine *helper : qAsConst(m_helpers))
+        helper->m_table = table;
 }
 
 
-Engine::Engine(int st) //: SuperEngine(st)
-    : m_strength(st)
-    , m_random(QRandomGenerator::global()->generate())
-    , m_computingMove(false)
+// Give a standalone engine, one that setTable() was never called for,
+// a table of its own.  The engines of the game all get the table they
+// share from their EngineService, so the constructors leave it out.
+// A table that has not been resized yet has no entries and stores
+// nothing.
+
+void Engine::EnsureTable()
 {
-    m_score = new Score;
-    m_bc_score = new Score;
-    SetupBcBoard();
-    SetupBits();
+    if (!m_table)
+        setTable(QSharedPointer<TranspositionTable>(new TranspositionTable));
 }
 
 
-Engine::Engine()// : SuperEngine(1)
-    : m_strength(1)
-    , m_random(QRandomGenerator::global()->generate())
-    , m_computingMove(false)
-{
-    m_score = new Score;
-    m_bc_score = new Score;
-    SetupBcBoard();
-    SetupBits();
-}
+// Play the moves from the opening book in fileName while in it.  An
+// empty fileName, or one that is not a book, means no book is used.
 
-Engine::~Engine()
+bool Engine::setOpeningBook(const QString &fileName)
 {
-    delete m_score;
-    delete m_bc_score;
+    if (fileName.isEmpty()) {
+        m_book.close();
+        return false;
+    }
+    return m_book.open(fileName);
 }
 
-// keep GUI alive
-void Engine::yield()
+
+// Search with this many threads.  The extra threads are helpers that
+// search the same position as the main one and share the transposition
+// table with it.  Must not be called while a move is being computed.
+
+void Engine::setThreads(int threads)
 {
-    qApp->processEvents();
+    threads = qMax(threads, 1);
+
+    while (m_helpers.size() > threads - 1)
+        delete m_helpers.takeLast();
+
+    while (m_helpers.size() < threads - 1) {
+        Engine *helper = new Engine(m_strength);
+        helper->m_table = m_table;
+        m_helpers.append(helper);
+    }
+
+    m_helper_threads.setMaxThreadCount(qMax(threads - 1, 1));
 }
 
 
-// Calculate the best move from the current position, and return it.
+// Calculate the best move for the player to move in position, and
+// return it.  An interrupt or stop from before the call still counts,
+// see clearInterrupt().
 
-KReversiMove Engine::computeMove(const KReversiGame& game, bool competitive)
+KReversiMove Engine::computeMove(const Position& position, bool competitive)
 {
     if (m_computingMove)
         return KReversiMove();
 
     m_computingMove = true;
-
-    ChipColor color;
+    m_pondering = false;
 
     // A competitive game is one where we try our damnedest to make the
     // best move.  The opposite is a casual game where the engine might
@@ -315,141 +452,537 @@ KReversiMove Engine::computeMove(const KReversiGame& game, bool competitive)
     // very move.
     m_competitive = competitive;
 
+    KReversiMove move = ComputeMove(position.toMove, position.player(), position.opponent());
+
+    m_computingMove = false;
+    return move;
+}
+
+
+// Same as computeMove(), but the search runs on the search thread of the
+// engine and the move is delivered through the returned future.  The
+// position is copied before this returns, so the game may change while
+// the engine is thinking.  Use setInterrupt() to stop the search early.
+
+QFuture<KReversiMove> Engine::startComputeMove(const Position& position, bool competitive)
+{
+    // A search that is still running has been superseded by this one.
+    // Once interrupted it returns within a few nodes.
+    if (m_computingMove) {
+        setInterrupt(true);
+        m_search_thread.waitForDone();
+    }
+
+    m_computingMove = true;
+    clearInterrupt();
+    m_pondering = false;
+    m_competitive = competitive;
+
+    const ChipColor color        = position.toMove;
+    const quint64   colorbits    = position.player();
+    const quint64   opponentbits = position.opponent();
+
+    return QtConcurrent::run(&m_search_thread, [this, color, colorbits, opponentbits]() {
+        KReversiMove move = ComputeMove(color, colorbits, opponentbits);
+        m_computingMove = false;
+        return move;
+    });
+}
+
+
+// Think on the opponent's time: position is the one after our move,
+// with the opponent to move.  If the transposition table knows the
+// reply we expect, search the position after it, otherwise search the
+// position itself, which helps with whatever reply comes.  The search
+// has no time limit until ponderHit() is called, and is stopped with
+// setInterrupt().
+
+QFuture<KReversiMove> Engine::startPonder(const Position& position, bool competitive)
+{
+    if (m_computingMove) {
+        setInterrupt(true);
+        m_search_thread.waitForDone();
+    }
+
+    m_ponder_position = PonderPosition(position);
+
+    m_computingMove = true;
+    clearInterrupt();
+    m_pondering = true;
+    m_competitive = competitive;
+
+    const Position ponder = m_ponder_position;
+    return QtConcurrent::run(&m_search_thread, [this, ponder]() {
+        KReversiMove move = ComputeMove(ponder.toMove, ponder.player(), ponder.opponent());
+        m_computingMove = false;
+        return move;
+    });
+}
+
+
+// The opponent played the move we were pondering on.  The time spent
+// pondering counts as time for our move, so if the opponent took longer
+// than we would have for it, the search ends at once.
+
+void Engine::ponderHit()
+{
+    m_pondering = false;
+}
+
+
+// The position to ponder on after position, see startPonder().
+
+Position Engine::PonderPosition(const Position& position)
+{
+    TranspositionTable::Entry entry;
+    const quint64 legal = Bitboard::legalMoves(position.player(), position.opponent());
+    if (!m_table || !m_table->probe(ComputeHash(position.toMove, position.player(), position.opponent()), entry)
+            || entry.move < 0 || !(legal & Bitboard::squareBit(entry.move)))
+        return position;
+
+    // If we would have to pass after the expected reply, there is
+    // nothing for us to think about.
+    Position reply = position;
+    reply.play(entry.move);
+    if (!Bitboard::legalMoves(reply.player(), reply.opponent()))
+        return position;
+    return reply;
+}
+
+
+// Find the values of the best count moves in position, see
+// analyze() in Engine.h.  The search is the same iterative deepening as
+// in ComputeMove(), without the opening book, the random first move and
+// the win/draw/loss search before the exact one, which only tells the
+// best move apart from the others.
+
+QVector<Engine::MoveAnalysis> Engine::analyze(const Position& position, int count)
+{
+    QVector<MoveAnalysis> analysis;
+    if (m_computingMove || position.toMove == NoColor)
+        return analysis;
+
+    m_computingMove = true;
+    m_pondering = false;
+    m_competitive = true;
+    m_exhaustive = false;
+    m_wld = false;
+    EnsureTable();
+
+    m_nodes_searched = 0;
+    StartMoveOrdering();
+    for (Engine *helper : qAsConst(m_helpers)) {
+        helper->m_nodes_searched = 0;
+        helper->StartMoveOrdering();
+    }
+
+    const ChipColor color        = position.toMove;
+    const quint64   colorbits    = position.player();
+    const quint64   opponentbits = position.opponent();
+    const int       discs        = Bitboard::popCount(colorbits | opponentbits);
+    const int       max_depth    = SearchLimits(discs);
+
+    MoveAndValue moves[60];
+    const int number_of_moves = CollectMoves(color, colorbits, opponentbits, moves);
+    if (count <= 0 || count > number_of_moves)
+        count = number_of_moves;
+
+    m_table->newSearch();
+    m_out_of_time = false;
+    m_next_check = CHECK_INTERVAL;
+    m_timer.start();
+
+    int depth = 0;
+    bool exhaustive = false;
+    for (m_depth = 1; m_depth <= max_depth && number_of_moves > 0;
+            m_depth = NextDepth(m_depth, max_depth)) {
+        m_exhaustive = (discs + m_depth >= 64);
+        if (!AnalyzeRoot(color, colorbits, opponentbits, moves, number_of_moves, count))
+            break;
+
+        depth = m_depth;
+        exhaustive = m_exhaustive;
+
+        analysis.clear();
+        for (int i = 0; i < count; i++) {
+            const int square = moves[i].m_square;
+            const int value = exhaustive ? moves[i].m_value * 100 : moves[i].m_value;
+            analysis.append({ KReversiMove(color, square / 8, square % 8), value,
+                              depth, exhaustive, MoveList() });
+        }
+
+        if (m_search_time > 0 && TimeUsed() * 2 > m_search_time)
+            break;
+    }
+
+    // The variations are read from the transposition table, as it was
+    // left by the last complete search.  The limits of the search don't
+    // apply anymore: if the time ran out, the search that was cut short
+    // has stopped already.
+    if (!interrupted()) {
+        m_depth = depth;
+        m_exhaustive = exhaustive;
+        m_out_of_time = false;
+        m_next_check = std::numeric_limits<int>::max();
+
+        for (MoveAnalysis &move : analysis)
+            move.variation = Variation(color, colorbits, opponentbits,
+                                       Bitboard::square(move.move.row, move.move.col));
+    } else
+        analysis.clear();
+
+    m_computingMove = false;
+    return analysis;
+}
+
+
+// Calculate the best move for color in the position given by the two
+// bitboards.
+
+KReversiMove Engine::ComputeMove(ChipColor color, quint64 colorbits, quint64 opponentbits)
+{
     // Suppose that we should give a heuristic evaluation.  If we are
     // close to the end of the game we can make an exhaustive search,
     // but that case is determined further down.
     m_exhaustive = false;
+    m_wld = false;
+    m_move_value = 0;
+    m_move_depth = 0;
+    m_move_exact = false;
+    EnsureTable();
 
-    // Get the color to calculate the move for.
-    color = game.currentPlayer();
-    if (color == NoColor) {
-        m_computingMove = false;
+    m_nodes_searched = 0;
+    for (Engine *helper : qAsConst(m_helpers))
+        helper->m_nodes_searched = 0;
+
+    if (color == NoColor)
         return KReversiMove();
-    }
 
     // Figure out the current score
-    m_score->set(White, game.playerScore(White));
-    m_score->set(Black, game.playerScore(Black));
+    m_score.set(color, Bitboard::popCount(colorbits));
+    m_score.set(Utils::opponentColorFor(color), Bitboard::popCount(opponentbits));
+
+    // As long as we are in the opening book, play its moves without any
+    // search.  Casual games are supposed to have some mistakes in them, so
+    // the book is only used in competitive ones.
+    if (m_competitive) {
+        const quint64 book_moves = m_book.moves(colorbits, opponentbits)
+                                   & Bitboard::legalMoves(colorbits, opponentbits);
+        if (book_moves)
+            return ComputeBookMove(color, book_moves);
+    }
 
     // Treat the first move as a special case (we can basically just
     // pick a move at random).
-    if (m_score->score(White) + m_score->score(Black) == 4) {
-        m_computingMove = false;
-        return ComputeFirstMove(game);
-    }
-
-    // Let there be room for 3000 changes during the recursive search.
-    // This is more than will ever be needed.
-    m_squarestack.init(3000);
-
-    // Get the search depth.  If we are close to the end of the game,
-    // the number of possible moves goes down, so we can search deeper
-    // without using more time.
-    m_depth = m_strength;
-    if (m_score->score(White) + m_score->score(Black) + m_depth + 3 >= 64)
-        m_depth = 64 - m_score->score(White) - m_score->score(Black);
-    else if (m_score->score(White) + m_score->score(Black) + m_depth + 4 >= 64)
-        m_depth += 2;
-    else if (m_score->score(White) + m_score->score(Black) + m_depth + 5 >= 64)
-        m_depth++;
-
-    // If we are very close to the end, we can even make the search
-    // exhaustive.
-    if (m_score->score(White) + m_score->score(Black) + m_depth >= 64)
-        m_exhaustive = true;
-
-    // The evaluation is a linear combination of the score (number of
-    // pieces) and the sum of the scores for the squares (given by
-    // m_bc_score).  The earlier in the game, the more we use the square
-    // values and the later in the game the more we use the number of
-    // pieces.
-    m_coeff = 100 - (100 *
-                     (m_score->score(White) + m_score->score(Black)
-                      + m_depth - 4)) / 60;
-
-    // Initialize the board that we use for the search.
-    for (uint x = 0; x < 10; x++)
-        for (uint y = 0; y < 10; y++) {
-            if (1 <= x && x <= 8
-                    && 1 <= y && y <= 8)
-                m_board[x][y] = game.chipColorAt(KReversiPos(y - 1, x - 1));
-            else
-                m_board[x][y] = NoColor;
-        }
+    if (m_score.score(White) + m_score.score(Black) == 4)
+        return ComputeFirstMove(color);
+
+    // Get the search limits.
+    const int discs = m_score.score(White) + m_score.score(Black);
+    const int max_depth = SearchLimits(discs);
 
     // Initialize a lot of stuff that we will use in the search.
 
-    // Initialize m_bc_score to the current bc score.  This is kept
-    // up-to-date incrementally so that way we won't have to calculate
-    // it from scratch for each evaluation.
-    m_bc_score->set(White, CalcBcScore(White));
-    m_bc_score->set(Black, CalcBcScore(Black));
+    // Initialize the indices of the evaluation tables.  They are kept
+    // up-to-date incrementally so that way we won't have to look at
+    // the whole board for each evaluation.
+    if (color == Black)
+        m_patterns.setup(colorbits, opponentbits);
+    else
+        m_patterns.setup(opponentbits, colorbits);
 
-    quint64 colorbits    = ComputeOccupiedBits(color);
-    quint64 opponentbits = ComputeOccupiedBits(Utils::opponentColorFor(color));
+    // Collect the legal moves.  Results from earlier searches, including
+    // those for earlier moves of the game, are still in m_table and are
+    // reused.
+    MoveAndValue moves[60];
+    int number_of_moves = CollectMoves(color, colorbits, opponentbits, moves);
+
+    m_table->newSearch();
+    StartMoveOrdering();
+    m_out_of_time = false;
+    m_next_check = CHECK_INTERVAL;
+    m_timer.start();
+
+    StartHelpers(color, colorbits, opponentbits, max_depth);
+
+    // Iterative deepening: search one level deeper each time until we
+    // reach max_depth or run out of time.  Each search tries the moves in
+    // the order of the values found by the previous one, and if the time
+    // runs out in the middle of a search, the move found by the last
+    // complete search is played.
+    int max_square = -1;
+    for (m_depth = 1; m_depth <= max_depth; m_depth = NextDepth(m_depth, max_depth)) {
+        // If this search goes all the way to the end of the game, it can
+        // be exhaustive.
+        m_exhaustive = (discs + m_depth >= 64);
+
+        // Before solving the game exactly, find out which moves win, draw
+        // or lose.  That is a lot faster, and the exact search then tries
+        // the winning moves first.  If it runs out of time, at least a move
+        // that keeps the best result possible is played.
+        if (m_exhaustive) {
+            m_wld = true;
+            int square = SearchRoot(color, colorbits, opponentbits,
+                                    moves, number_of_moves);
+            m_wld = false;
+            if (square < 0)
+                break;
+            max_square = square;
+        }
 
-    int maxval = -LARGEINT;
-    int max_x = 0;
-    int max_y = 0;
+        int square = SearchRoot(color, colorbits, opponentbits,
+                                moves, number_of_moves);
+        if (square < 0)
+            break;
+        max_square = square;
+
+        // The move played is first now.  The values of an exhaustive
+        // search are in whole chips.
+        m_move_value = m_exhaustive ? moves[0].m_value * 100 : moves[0].m_value;
+        m_move_depth = m_depth;
+        m_move_exact = m_exhaustive;
+
+        if (m_progress) {
+            Position position;
+            position.black = (color == Black) ? colorbits : opponentbits;
+            position.white = (color == Black) ? opponentbits : colorbits;
+            position.toMove = color;
+            m_progress(position, KReversiMove(color, square / 8, square % 8), m_depth);
+        }
 
-    MoveAndValue moves[60];
+        // A deeper search takes several times as long, so don't start
+        // one that is not going to finish anyway.
+        if (m_search_time > 0 && TimeUsed() * 2 > m_search_time)
+            break;
+    }
+
+    StopHelpers();
+
+    // If not even the first search was done, any legal move is better
+    // than none.
+    if (max_square < 0 && number_of_moves > 0)
+        max_square = moves[0].m_square;
+
+    // Return a suitable move.
+    if (interrupted())
+        return KReversiMove(NoColor, -1, -1);
+    else if (max_square >= 0)
+        return KReversiMove(color, max_square / 8, max_square % 8);
+    else
+        return KReversiMove(NoColor, -1, -1);
+}
+
+
+// Set up the limits of a search in a position with discs chips on the
+// board and return the deepest it goes.  If we are close to the end of
+// the game, the number of possible moves goes down, so we can search
+// deeper without using more time.  A depth limit that reaches the end
+// of the game asks for the game to be solved.
+//
+
+int Engine::SearchLimits(int discs)
+{
+    const StrengthLimits &limits = STRENGTH_LIMITS[qBound(0, int(m_strength), MAX_STRENGTH)];
+
+    const int empties = 64 - discs;
+    int max_depth = (m_depth_limit > 0) ? m_depth_limit : limits.depth;
+    m_solve = (empties <= limits.solve || (m_depth_limit > 0 && m_depth_limit >= empties));
+    if (m_solve)
+        max_depth = empties;
+    else if (discs + max_depth + 4 >= 64)
+        max_depth += 2;
+    else if (discs + max_depth + 5 >= 64)
+        max_depth++;
+    max_depth = qMin(max_depth, empties);
+
+    m_search_time = (m_time_limit > 0) ? m_time_limit : limits.msecs;
+
+    return max_depth;
+}
+
+
+// The depth of the next iteration of iterative deepening.  Normally one
+// level deeper, but when the game is going to be solved, the deeper
+// heuristic searches are skipped: the endgame solver is so much faster
+// that they would only waste time.
+//
+
+int Engine::NextDepth(int depth, int max_depth) const
+{
+    if (m_solve && depth >= PRESOLVE_DEPTH)
+        return qMax(depth + 1, max_depth);
+    return depth + 1;
+}
+
+
+// Put the legal moves for color into moves and return how many there
+// are.  If we already know the best move from an earlier search, it is
+// put first.
+//
+
+int Engine::CollectMoves(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                         MoveAndValue *moves)
+{
     int number_of_moves = 0;
-    int number_of_maxval = 0;
+    TranspositionTable::Entry entry;
+    int hash_move = m_table->probe(ComputeHash(color, colorbits, opponentbits), entry)
+                    ? entry.move : -1;
+
+    for (quint64 legal = Bitboard::legalMoves(colorbits, opponentbits);
+            legal; legal &= legal - 1) {
+        const int square = Bitboard::firstSquare(legal);
+        moves[number_of_moves++].setSV(square, 0);
+        if (square == hash_move)
+            qSwap(moves[0], moves[number_of_moves - 1]);
+    }
 
-    setInterrupt(false);
+    return number_of_moves;
+}
 
-    quint64 null_bits;
-    null_bits = 0;
 
-    // The main search loop.  Step through all possible moves and keep
-    // track of the most valuable one.  This move is stored in
-    // (max_x, max_y) and the value is stored in maxval.
+// Let the helpers search the same position as we do, each on a thread
+// of its own (so called lazy SMP).  The helpers are not told anything
+// about our search and we don't look at their results.  All they do is
+// fill the shared transposition table, so that we find many positions
+// there already searched, often deeper than we need.  Half of the
+// helpers start one level deeper than the others, so that they are not
+// all working on the same positions at the same time.
+//
+
+void Engine::StartHelpers(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                          int max_depth)
+{
+    // Shallow searches are over before a thread has even started.
+    if (max_depth < 3)
+        return;
+
+    for (int i = 0; i < m_helpers.size(); ++i) {
+        Engine *helper = m_helpers[i];
+        const int first_depth = qMin(2 + i % 2, max_depth);
+
+        helper->setInterrupt(false);
+        helper->m_stop = false;
+        helper->m_solve = m_solve;
+        QtConcurrent::run(&m_helper_threads, [helper, color, colorbits, opponentbits,
+                                              first_depth, max_depth]() {
+            helper->HelpSearch(color, colorbits, opponentbits, first_depth, max_depth);
+        });
+    }
+}
+
+
+// Stop the helpers and wait for them.
+//
+
+void Engine::StopHelpers()
+{
+    for (Engine *helper : qAsConst(m_helpers))
+        helper->setInterrupt(true);
+    m_helper_threads.waitForDone();
+}
+
+
+// The search done by a helper: iterative deepening from first_depth to
+// max_depth, or until the main search stops us.  The moves found don't
+// matter, only what is stored in the transposition table on the way.
+//
+
+void Engine::HelpSearch(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                        int first_depth, int max_depth)
+{
+    const int discs = Bitboard::popCount(colorbits | opponentbits);
+
+    m_score.set(color, Bitboard::popCount(colorbits));
+    m_score.set(Utils::opponentColorFor(color), Bitboard::popCount(opponentbits));
+    if (color == Black)
+        m_patterns.setup(colorbits, opponentbits);
+    else
+        m_patterns.setup(opponentbits, colorbits);
+
+    MoveAndValue moves[60];
+    int number_of_moves = CollectMoves(color, colorbits, opponentbits, moves);
+
+    m_competitive = true;
+    m_search_time = 0;
+    m_node_limit = 0;
+    m_out_of_time = false;
     m_nodes_searched = 0;
-    for (int x = 1; x < 9; x++) {
-        for (int y = 1; y < 9; y++) {
-            // Don't bother with non-empty squares and squares that aren't
-            // neighbors to opponent pieces.
-            if (m_board[x][y] != NoColor
-                    || (m_neighbor_bits[x][y] & opponentbits) == null_bits)
-                continue;
-
-
-            int val = ComputeMove2(x, y, color, 1, maxval,
-                                   colorbits, opponentbits);
-
-            if (val != ILLEGAL_VALUE) {
-                moves[number_of_moves++].setXYV(x, y, val);
-
-                // If the move is better than all previous moves, then record
-                // this fact...
-                if (val > maxval) {
-
-                    // ...except that we want to make the computer miss some
-                    // good moves so that beginners can play against the program
-                    // and not always lose.  However, we only do this if the
-                    // user wants a casual game, which is set in the settings
-                    // dialog.
-                    int randi = m_random.bounded(7);
-                    if (maxval == -LARGEINT
-                            || m_competitive
-                            || randi < (int) m_strength) {
-                        maxval = val;
-                        max_x  = x;
-                        max_y  = y;
+    m_next_check = CHECK_INTERVAL;
+    StartMoveOrdering();
 
-                        number_of_maxval = 1;
-                    }
-                } else if (val == maxval)
-                    number_of_maxval++;
-            }
+    m_wld = false;
 
-            // Jump out prematurely if interrupt is set.
-            if (interrupted())
-                break;
-        }
+    for (m_depth = first_depth; m_depth <= max_depth;
+            m_depth = NextDepth(m_depth, max_depth)) {
+        m_exhaustive = (discs + m_depth >= 64);
+        if (SearchRoot(color, colorbits, opponentbits, moves, number_of_moves) < 0)
+            break;
     }
+}
 
-    // long endtime = times(&tmsdummy);
+
+// Search all moves at the root to the depth m_depth, in the order they
+// are given in moves.  Afterwards the moves are sorted by the values
+// found, so that the next, deeper search tries the best ones first.
+// Return the square of the move to make, or -1 if the search was
+// aborted.
+//
+
+int Engine::SearchRoot(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                       MoveAndValue *moves, int number_of_moves)
+{
+    NoAllocations no_allocations;
+    const quint64 hash = ComputeHash(color, colorbits, opponentbits);
+
+    int maxval = -LARGEINT;
+    int max_square = -1;
+    int number_of_maxval = 0;
+
+    // The main search loop.  Step through all legal moves and keep
+    // track of the most valuable one.  This move is stored in
+    // max_square and the value is stored in maxval.  Moves that are
+    // only as good as the best one so far must get their exact value as
+    // well, so that we can pick randomly among them below.
+    for (int i = 0; i < number_of_moves; i++) {
+        const int square = moves[i].m_square;
+        const int alpha = (maxval == -LARGEINT) ? -LARGEINT : maxval - 1;
+
+        int val = ComputeMove2(square, color, 1, alpha, LARGEINT,
+                               colorbits, opponentbits, hash);
+
+        // Jump out prematurely if interrupt is set or we are out of time.
+        if (val == ILLEGAL_VALUE || Aborted())
+            return -1;
+
+        moves[i].m_value = val;
+
+        // If the move is better than all previous moves, then record
+        // this fact...
+        if (val > maxval) {
+
+            // ...except that we want to make the computer miss some
+            // good moves so that beginners can play against the program
+            // and not always lose.  However, we only do this if the
+            // user wants a casual game, which is set in the settings
+            // dialog.
+            int randi = m_random.bounded(7);
+            if (maxval == -LARGEINT
+                    || m_competitive
+                    || randi < (int) m_strength) {
+                maxval     = val;
+                max_square = square;
+
+                number_of_maxval = 1;
+            }
+        } else if (val == maxval)
+            number_of_maxval++;
+    }
+
+    // Remember the result of a complete search for the next time we see
+    // this position.  A win/draw/loss search doesn't find real values.
+    if (m_competitive && !m_wld && maxval != -LARGEINT)
+        m_table->store(hash, m_depth, TranspositionTable::Exact, maxval,
+                      max_square);
 
     // If there are more than one best move, the pick one randomly.
     if (number_of_maxval > 1) {
@@ -461,28 +994,182 @@ KReversiMove Engine::computeMove(const KReversiGame& game, bool competitive)
                 break;
         }
 
-        max_x = moves[i].m_x;
-        max_y = moves[i].m_y;
+        max_square = moves[i].m_square;
     }
 
-    m_computingMove = false;
-    // Return a suitable move.
-    if (interrupted())
-        return KReversiMove(NoColor, -1, -1);
-    else if (maxval != -LARGEINT)
-        return KReversiMove(color, max_y - 1, max_x - 1);
+    // Order the moves for the next search: the chosen one first, then
+    // the others by value.
+    SortMoves(moves, number_of_moves,
+              [max_square](const MoveAndValue &a, const MoveAndValue &b) {
+        if (a.m_square == max_square || b.m_square == max_square)
+            return a.m_square == max_square && b.m_square != max_square;
+        return a.m_value > b.m_value;
+    });
+
+    return max_square;
+}
+
+
+// The moves at the root of an analysis, shared by the engine and its
+// helpers while they search them.  values holds the number_of_values
+// values of the moves searched so far that may be among the best count,
+// best first.
+//
+
+struct Engine::RootMoves {
+    ChipColor        color;
+    quint64          colorbits;
+    quint64          opponentbits;
+    MoveAndValue    *moves;
+    int              number_of_moves;
+    int              count;
+    std::atomic<int> next;
+    QMutex           mutex;
+    int              values[60];
+    int              number_of_values;
+};
+
+
+// Search all moves at the root to the depth m_depth, like SearchRoot()
+// does, but find the real values of the best count of them.  The others
+// only need to be shown to be worse than the count best found so far,
+// which is a lot faster.  The helpers, if there are any, take the moves
+// in turn with us.  Afterwards the moves are sorted by the values found,
+// and false is returned if the search was aborted.
+//
+
+bool Engine::AnalyzeRoot(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                         MoveAndValue *moves, int number_of_moves, int count)
+{
+    RootMoves root;
+    root.color           = color;
+    root.colorbits       = colorbits;
+    root.opponentbits    = opponentbits;
+    root.moves           = moves;
+    root.number_of_moves = number_of_moves;
+    root.count           = count;
+    root.next            = 0;
+    root.number_of_values = 0;
+
+    // The helpers stop when our time is up, or when we are stopped or
+    // interrupted.
+    for (Engine *helper : qAsConst(m_helpers)) {
+        helper->m_depth       = m_depth;
+        helper->m_exhaustive  = m_exhaustive;
+        helper->m_wld         = false;
+        helper->m_competitive = true;
+        helper->m_search_time = m_search_time;
+        helper->m_timer       = m_timer;
+        helper->m_node_limit  = 0;
+        helper->m_out_of_time = false;
+        helper->m_next_check  = CHECK_INTERVAL;
+        QtConcurrent::run(&m_helper_threads, [helper, &root]() {
+            helper->AnalyzeMoves(root);
+        });
+    }
+
+    AnalyzeMoves(root);
+    if (Aborted())
+        StopHelpers();
     else
-        return KReversiMove(NoColor, -1, -1);
+        m_helper_threads.waitForDone();
+
+    bool aborted = Aborted();
+    for (const Engine *helper : qAsConst(m_helpers))
+        aborted = aborted || helper->Aborted();
+    if (aborted)
+        return false;
+
+    SortMoves(moves, number_of_moves,
+              [](const MoveAndValue &a, const MoveAndValue &b) {
+        return a.m_value > b.m_value;
+    });
+
+    return true;
+}
+
+
+// Take moves from root and search them until there are none left.  A
+// move is first searched with a null window at the value it needs to
+// be among the best root.count moves, and only if it is, searched again
+// to get its real value.  The value of a move that is not is only an
+// upper bound, and lower than that of the others.
+//
+
+void Engine::AnalyzeMoves(RootMoves &root)
+{
+    const ChipColor color        = root.color;
+    const quint64   colorbits    = root.colorbits;
+    const quint64   opponentbits = root.opponentbits;
+    const quint64   hash         = ComputeHash(color, colorbits, opponentbits);
+
+    m_score.set(color, Bitboard::popCount(colorbits));
+    m_score.set(Utils::opponentColorFor(color), Bitboard::popCount(opponentbits));
+    if (color == Black)
+        m_patterns.setup(colorbits, opponentbits);
+    else
+        m_patterns.setup(opponentbits, colorbits);
+
+    for (int i = root.next++; i < root.number_of_moves; i = root.next++) {
+        const int square = root.moves[i].m_square;
+
+        int bound = -LARGEINT;
+        {
+            QMutexLocker locker(&root.mutex);
+            if (root.number_of_values >= root.count)
+                bound = root.values[root.count - 1];
+        }
+
+        int val;
+        {
+            NoAllocations no_allocations;
+            if (bound == -LARGEINT)
+                val = ComputeMove2(square, color, 1, -LARGEINT, LARGEINT,
+                                   colorbits, opponentbits, hash);
+            else {
+                val = ComputeMove2(square, color, 1, bound - 1, bound,
+                                   colorbits, opponentbits, hash);
+                if (val != ILLEGAL_VALUE && val >= bound)
+                    val = ComputeMove2(square, color, 1, bound - 1, LARGEINT,
+                                       colorbits, opponentbits, hash);
+            }
+        }
+
+        if (val == ILLEGAL_VALUE || Aborted())
+            return;
+
+        root.moves[i].m_value = val;
+        if (val >= bound) {
+            QMutexLocker locker(&root.mutex);
+            int j = root.number_of_values++;
+            for (; j > 0 && root.values[j - 1] < val; --j)
+                root.values[j] = root.values[j - 1];
+            root.values[j] = val;
+        }
+    }
+}
+
+
+// Pick one of the moves in book_moves.  There is more than one only in
+// symmetric positions, where they are all equally good.
+//
+
+KReversiMove Engine::ComputeBookMove(ChipColor color, quint64 book_moves)
+{
+    for (int r = m_random.bounded(Bitboard::popCount(book_moves)); r > 0; r--)
+        book_moves &= book_moves - 1;
+
+    const int square = Bitboard::firstSquare(book_moves);
+    return KReversiMove(color, square / 8, square % 8);
 }
 
 
 // Get the first move.  We can pick any move at random.
 //
 
-KReversiMove Engine::ComputeFirstMove(const KReversiGame& game)
+KReversiMove Engine::ComputeFirstMove(ChipColor color)
 {
     int    r;
-    ChipColor  color = game.currentPlayer();
 
     r = m_random.bounded(4) + 1;
 
@@ -500,295 +1187,885 @@ KReversiMove Engine::ComputeFirstMove(const KReversiGame& game)
 }
 
 
-// Play a move at (xplay, yplay) and generate a value for it.  If we
-// are at the maximum search depth, we get the value by calling
-// EvaluatePosition(), otherwise we get it by performing an alphabeta
-// search.
+// Play a move at square and generate a value for it.  If we are at
+// the depth of the current iteration (m_depth), we get the value by
+// calling EvaluatePosition(), otherwise we get it by an alphabeta
+// search of the replies with TryAllMoves(), or TryLeafMoves() one level
+// above the bottom.  An exhaustive search hands the position to the
+// endgame solver instead.  Values that are not within (alpha, beta) are
+// only bounds of the real value.  hash is the hash of the position
+// before the move.
+//
+// The search below is a set of templates, with a version for each color
+// and for heuristic and exhaustive search, so that the compiler knows
+// them at every node instead of the search asking again and again.
+// This function picks the right version.
 //
 
-int Engine::ComputeMove2(int xplay, int yplay, ChipColor color, int level,
-                         int cutoffval, quint64 colorbits,
-                         quint64 opponentbits)
+int Engine::ComputeMove2(int square, ChipColor color, int level,
+                         int alpha, int beta, quint64 colorbits,
+                         quint64 opponentbits, quint64 hash)
 {
-    int               number_of_turned = 0;
-    SquareStackEntry  mse;
-    ChipColor             opponent = Utils::opponentColorFor(color);
+    if (color == White) {
+        if (m_exhaustive)
+            return ComputeMove2<White, true>(square, level, alpha, beta,
+                                             colorbits, opponentbits, hash);
+        return ComputeMove2<White, false>(square, level, alpha, beta,
+                                          colorbits, opponentbits, hash);
+    }
+
+    if (m_exhaustive)
+        return ComputeMove2<Black, true>(square, level, alpha, beta,
+                                         colorbits, opponentbits, hash);
+    return ComputeMove2<Black, false>(square, level, alpha, beta,
+                                      colorbits, opponentbits, hash);
+}
+
+
+template<ChipColor Color, bool Exhaustive>
+int Engine::ComputeMove2(int square, int level, int alpha, int beta,
+                         quint64 colorbits, quint64 opponentbits, quint64 hash)
+{
+    const ChipColor opponent = (Color == White) ? Black : White;
+
+    // Find all the pieces that this move turns.  If there are none,
+    // then the square was not a legal move.
+    const quint64 flips = Bitboard::flips(square, colorbits, opponentbits);
+    if (!flips)
+        return ILLEGAL_VALUE;
 
     m_nodes_searched++;
 
-    // Put the piece on the board and incrementally update scores and bitmaps.
-    m_board[xplay][yplay] = color;
-    colorbits |= m_coord_bit[xplay][yplay];
-    m_score->inc(color);
-    m_bc_score->add(color, m_bc_board[xplay][yplay]);
-
-    // Loop through all 8 directions and turn the pieces that can be turned.
-    for (int xinc = -1; xinc <= 1; xinc++)
-        for (int yinc = -1; yinc <= 1; yinc++) {
-            if (xinc == 0 && yinc == 0)
-                continue;
-
-            int x, y;
-
-            for (x = xplay + xinc, y = yplay + yinc; m_board[x][y] == opponent;
-                    x += xinc, y += yinc)
-                ;
-
-            // If we found the end of a turnable row, then go back and turn
-            // all pieces on the way back.  Also push the squares with
-            // turned pieces on the squarestack so that we can undo the move
-            // later.
-            if (m_board[x][y] == color)
-                for (x -= xinc, y -= yinc; x != xplay || y != yplay;
-                        x -= xinc, y -= yinc) {
-                    m_board[x][y] = color;
-                    colorbits |= m_coord_bit[x][y];
-                    opponentbits &= ~m_coord_bit[x][y];
-
-                    m_squarestack.Push(x, y);
-
-                    m_bc_score->add(color, m_bc_board[x][y]);
-                    m_bc_score->sub(opponent, m_bc_board[x][y]);
-                    number_of_turned++;
-                }
-        }
+    // Put the piece on the board and turn the pieces.  The bitboards are
+    // our own copies, so there is no need to turn the pieces back when we
+    // are done.
+    colorbits    ^= flips | Bitboard::squareBit(square);
+    opponentbits ^= flips;
+
+    // The rest of an exhaustive search is done by the endgame solver,
+    // which needs neither the scores nor the patterns.  Its values are
+    // never outside of -64..64, so the window is narrowed down to that.
+    if (Exhaustive) {
+        int retval;
+        if (m_wld) {
+            int val = -Solve(opponentbits, colorbits, -1, 1);
+            retval = (val > 0) - (val < 0);
+        } else
+            retval = -Solve(opponentbits, colorbits,
+                            -qMin(beta, SOLVER_INFINITY), -qMax(alpha, -SOLVER_INFINITY));
+
+        return Aborted() ? ILLEGAL_VALUE : retval;
+    }
 
-    int retval = -LARGEINT;
+    // Incrementally update the scores and the patterns.
+    const int number_of_turned = Bitboard::popCount(flips);
 
-    // If we managed to turn at least one piece, then (xplay, yplay) was
-    // a legal move.  Now find out the value of the move.
-    if (number_of_turned > 0) {
+    m_score.add(Color, number_of_turned + 1);
+    m_score.sub(opponent, number_of_turned);
+    m_patterns.play<Color>(square, flips);
 
-        // First adjust the number of pieces for each side.
-        m_score->add(color, number_of_turned);
-        m_score->sub(opponent, number_of_turned);
+    int retval = -LARGEINT;
 
-        // If we are at the bottom of the search, get the evaluation.
-        if (level >= m_depth)
-            retval = EvaluatePosition(color); // Terminal node
+    // If we are at the bottom of the search, get the evaluation.
+    if (level >= m_depth)
+        retval = EvaluatePosition<Color>(); // Terminal node
+    else {
+        int maxval;
+
+        // One level above the bottom the moves are tried by
+        // TryLeafMoves(), which doesn't use the table, so it doesn't
+        // need the hash either.
+        if (level + 1 >= m_depth)
+            maxval = TryLeafMoves<opponent>(-beta, -alpha, opponentbits, colorbits);
         else {
-            int maxval = TryAllMoves(opponent, level, cutoffval, opponentbits,
-                                     colorbits);
+            hash ^= ZOBRIST.piece[Color][square] ^ ZOBRIST.side;
+            for (quint64 turned = flips; turned; turned &= turned - 1)
+                hash ^= ZOBRIST.flip[Bitboard::firstSquare(turned)];
 
-            if (maxval != -LARGEINT)
-                retval = -maxval;
-            else {
+            maxval = TryAllMoves<opponent>(level, -beta, -alpha,
+                                           opponentbits, colorbits, hash);
+        }
 
-                // No possible move for the opponent, it is colors turn again:
-                retval = TryAllMoves(color, level, -LARGEINT, colorbits, opponentbits);
+        if (maxval != -LARGEINT)
+            retval = -maxval;
+        else {
 
-                if (retval == -LARGEINT) {
+            // No possible move for the opponent, it is colors turn again:
+            if (level + 1 >= m_depth)
+                retval = TryLeafMoves<Color>(alpha, beta, colorbits, opponentbits);
+            else
+                retval = TryAllMoves<Color>(level, alpha, beta,
+                                            colorbits, opponentbits, hash ^ ZOBRIST.side);
 
-                    // No possible move for anybody => end of game:
-                    int finalscore = m_score->score(color) - m_score->score(opponent);
+            if (retval == -LARGEINT) {
 
-                    if (m_exhaustive)
-                        retval = finalscore;
-                    else {
-                        // Take a sure win and avoid a sure loss (may not be optimal):
+                // No possible move for anybody => end of game:
+                int finalscore = m_score.score(Color) - m_score.score(opponent);
 
-                        if (finalscore > 0)
-                            retval = LARGEINT - 65 + finalscore;
-                        else if (finalscore < 0)
-                            retval = -(LARGEINT - 65 + finalscore);
-                        else
-                            retval = 0;
-                    }
-                }
+                // Take a sure win and avoid a sure loss (may not be optimal):
+                if (finalscore > 0)
+                    retval = LARGEINT - 65 + finalscore;
+                else if (finalscore < 0)
+                    retval = -(LARGEINT - 65 + finalscore);
+                else
+                    retval = 0;
             }
         }
-
-        m_score->add(opponent, number_of_turned);
-        m_score->sub(color, number_of_turned);
-    }
-
-    // Undo the move.  Start by unturning the turned pieces.
-    for (int i = number_of_turned; i > 0; i--) {
-        mse = m_squarestack.Pop();
-        m_bc_score->add(opponent, m_bc_board[mse.m_x][mse.m_y]);
-        m_bc_score->sub(color, m_bc_board[mse.m_x][mse.m_y]);
-        m_board[mse.m_x][mse.m_y] = opponent;
     }
 
-    // Now remove the new piece that we put down.
-    m_board[xplay][yplay] = NoColor;
-    m_score->sub(color, 1);
-    m_bc_score->sub(color, m_bc_board[xplay][yplay]);
+    // Undo the move in the scores.
+    m_score.sub(Color, number_of_turned + 1);
+    m_score.add(opponent, number_of_turned);
+    m_patterns.undo<Color>(square, flips);
 
     // Return a suitable value.
-    if (number_of_turned < 1 || interrupted())
+    if (Aborted())
         return ILLEGAL_VALUE;
     else
         return retval;
 }
 
 
+// The time used for the current move.  While pondering there is no
+// limit, so none is used.
+
+qint64 Engine::TimeUsed() const
+{
+    return m_pondering ? 0 : m_timer.elapsed();
+}
+
+
+// Stop the search when it has used up its time or nodes, or when asked
+// to.
+//
+
+void Engine::CheckLimits()
+{
+    if ((m_search_time > 0 && TimeUsed() >= m_search_time)
+            || (m_node_limit > 0 && m_nodes_searched >= m_node_limit)
+            || m_stop)
+        m_out_of_time = true;
+}
+
+
 // Generate all legal moves from the current position, and do a search
 // to see the value of them.  This function returns the value of the
-// most valuable move, but not the move itself.
+// most valuable move, but not the move itself.  If the position is in
+// the transposition table, the stored result is used instead when it
+// is good enough, and otherwise its best move is tried first.  Color is
+// the color to move, with the pieces colorbits.
 //
 
-int Engine::TryAllMoves(ChipColor opponent, int level, int cutoffval,
-                        quint64 opponentbits, quint64 colorbits)
+template<ChipColor Color>
+int Engine::TryAllMoves(int level, int alpha, int beta,
+                        quint64 colorbits, quint64 opponentbits, quint64 hash)
 {
-    int maxval = -LARGEINT;
+    quint64 legal = Bitboard::legalMoves(colorbits, opponentbits);
+    if (!legal)
+        return -LARGEINT;
 
-    // Keep GUI alive by calling the event loop.
-    yield();
+    // Just above the leaves the table costs more than it saves, so it is
+    // only used further up in the tree.
+    const int depth = m_depth - level;
+    const bool use_table = depth >= MIN_TABLE_DEPTH;
+    int hash_move = -1;
+
+    TranspositionTable::Entry entry;
+    if (use_table && m_table->probe(hash, entry)) {
+        if (entry.depth >= depth) {
+            if (entry.bound == TranspositionTable::Exact
+                    || (entry.bound == TranspositionTable::Lower && entry.score >= beta)
+                    || (entry.bound == TranspositionTable::Upper && entry.score <= alpha))
+                return entry.score;
+        }
+        hash_move = entry.move;
+    }
 
-    quint64  null_bits;
-    null_bits = 0;
+    // Every now and then see whether we have used up the time or nodes
+    // for this move.
+    if (--m_next_check <= 0) {
+        m_next_check = CHECK_INTERVAL;
+        CheckLimits();
+    }
 
-    for (int x = 1; x < 9; x++) {
-        for (int y = 1; y < 9; y++) {
-            if (m_board[x][y] == NoColor
-                    && (m_neighbor_bits[x][y] & colorbits) != null_bits) {
-                int val = ComputeMove2(x, y, opponent, level + 1, maxval, opponentbits,
-                                       colorbits);
+    const int original_alpha = alpha;
+    int maxval = -LARGEINT;
+    int max_square = -1;
+
+    // The move from the table is tried on its own first.  Often it causes
+    // a cutoff, and the other moves are never looked at.  Only then they
+    // are given keys by OrderMoves(), and each time the one with the
+    // highest key that is left is tried next.
+    int squares[60];
+    int keys[60];
+    int number_of_moves = 0;
+    if (hash_move >= 0 && (legal & Bitboard::squareBit(hash_move))) {
+        squares[number_of_moves++] = hash_move;
+        legal &= ~Bitboard::squareBit(hash_move);
+    }
 
-                if (val != ILLEGAL_VALUE && val > maxval) {
-                    maxval = val;
-                    if (maxval > -cutoffval || interrupted())
-                        break;
-                }
+    for (int i = 0; ; ++i) {
+        if (i == number_of_moves) {
+            if (!legal)
+                break;
+            number_of_moves += OrderMoves<Color>(level, depth, colorbits, opponentbits, legal,
+                                                 squares + number_of_moves, keys + number_of_moves);
+            legal = 0;
+        }
+
+        for (int j = i + 1; j < number_of_moves; ++j) {
+            if (keys[j] > keys[i]) {
+                qSwap(squares[i], squares[j]);
+                qSwap(keys[i], keys[j]);
+            }
+        }
+        const int square = squares[i];
+
+        int val = ComputeMove2<Color, false>(square, level + 1, alpha, beta,
+                                             colorbits, opponentbits, hash);
+
+        if (val != ILLEGAL_VALUE && val > maxval) {
+            maxval = val;
+            max_square = square;
+            if (maxval > alpha)
+                alpha = maxval;
+            if (alpha >= beta) {
+                RememberCutoff<Color>(level, depth, square);
+                break;
             }
         }
 
-        if (maxval > -cutoffval || interrupted())
+        if (Aborted())
             break;
     }
 
-    if (interrupted())
+    if (Aborted())
         return -LARGEINT;
 
+    if (!use_table)
+        return maxval;
+
+    TranspositionTable::Bound bound = TranspositionTable::Exact;
+    if (maxval <= original_alpha)
+        bound = TranspositionTable::Upper;
+    else if (maxval >= beta)
+        bound = TranspositionTable::Lower;
+    m_table->store(hash, depth, bound, maxval, max_square);
+
     return maxval;
 }
 
+// Give each of the legal moves a key for TryAllMoves(), the higher the
+// sooner the move is tried: first the killer moves of this level, then
+// the other moves by their history.  Far enough from the leaves the
+// moves that leave the opponent the fewest replies go before the others,
+// with the history deciding between those that leave as many.  Finding
+// out how many replies there are takes time, but up there a cutoff
+// saves a lot more.  Return the number of moves.
+//
+
+template<ChipColor Color>
+int Engine::OrderMoves(int level, int depth, quint64 colorbits, quint64 opponentbits,
+                       quint64 legal, int *squares, int *keys) const
+{
+    const int *killers = m_killers[level];
+    const int *history = m_history[Color];
+
+    int number_of_moves = 0;
+    for (; legal; legal &= legal - 1) {
+        const int square = Bitboard::firstSquare(legal);
+
+        int key;
+        if (square == killers[0])
+            key = KILLER_KEY + 1;
+        else if (square == killers[1])
+            key = KILLER_KEY;
+        else if (depth >= MOBILITY_ORDER_DEPTH) {
+            const quint64 flips = Bitboard::flips(square, colorbits, opponentbits);
+            const int replies = Bitboard::mobility(opponentbits ^ flips,
+                                                   colorbits ^ flips ^ Bitboard::squareBit(square));
+            key = (64 - replies) * (HISTORY_LIMIT + 1) + history[square];
+        } else
+            key = history[square];
+
+        squares[number_of_moves] = square;
+        keys[number_of_moves] = key;
+        number_of_moves++;
+    }
 
-// Calculate a heuristic value for the current position.  If we are at
-// the end of the game, do this by counting the pieces.  Otherwise do
-// it by combining the score using the number of pieces, and the score
-// using the board control values.
+    return number_of_moves;
+}
+
+// Remember that the move on square caused a cutoff at level, depth
+// levels above the leaves: it becomes the first killer move of the
+// level, and its history grows the more, the more of the tree it cut
+// off.  Before the history gets too large for the keys of OrderMoves(),
+// all of it is halved.
 //
 
-int Engine::EvaluatePosition(ChipColor color)
+template<ChipColor Color>
+void Engine::RememberCutoff(int level, int depth, int square)
 {
-    int retval;
+    int *killers = m_killers[level];
+    if (killers[0] != square) {
+        killers[1] = killers[0];
+        killers[0] = square;
+    }
 
-    ChipColor opponent = Utils::opponentColorFor(color);
+    int *history = m_history[Color];
+    history[square] += depth * depth;
+    if (history[square] > HISTORY_LIMIT) {
+        for (int *color_history : m_history) {
+            for (int i = 0; i < 64; i++)
+                color_history[i] /= 2;
+        }
+    }
+}
+
+// Before a search: the killer moves were found in another position and
+// are forgotten.  The history is still mostly right one move later,
+// but only counts half as much as what the new search finds.
+//
 
-    int    score_color    = m_score->score(color);
-    int    score_opponent = m_score->score(opponent);
+void Engine::StartMoveOrdering()
+{
+    for (int *killers : m_killers)
+        killers[0] = killers[1] = -1;
 
-    if (m_exhaustive)
-        retval = score_color - score_opponent;
-    else {
-        retval = (100 - m_coeff) *
-                 (m_score->score(color) - m_score->score(opponent))
-                 + m_coeff * BC_WEIGHT * (m_bc_score->score(color)
-                                          - m_bc_score->score(opponent));
+    for (int *color_history : m_history) {
+        for (int i = 0; i < 64; i++)
+            color_history[i] /= 2;
     }
+}
+
+// TryAllMoves() for the last level of the search, where every move
+// only needs to be evaluated.  There is no table to look at and no
+// scores or hash to keep up to date, nor any deeper search to prepare,
+// so each move is evaluated on a copy of the pattern indices, with
+// nothing to take back afterwards.
+//
 
-    return retval;
+template<ChipColor Color>
+int Engine::TryLeafMoves(int alpha, int beta, quint64 colorbits, quint64 opponentbits)
+{
+    quint64 legal = Bitboard::legalMoves(colorbits, opponentbits);
+    if (!legal)
+        return -LARGEINT;
+
+    if (--m_next_check <= 0) {
+        m_next_check = CHECK_INTERVAL;
+        CheckLimits();
+    }
+
+    int maxval = -LARGEINT;
+    for (; legal; legal &= legal - 1) {
+        const int square = Bitboard::firstSquare(legal);
+        const quint64 flips = Bitboard::flips(square, colorbits, opponentbits);
+
+        m_nodes_searched++;
+        const int val = -m_patterns.evaluateAfter<Color>(square, flips);
+
+        if (val > maxval) {
+            maxval = val;
+            if (maxval > alpha)
+                alpha = maxval;
+            if (alpha >= beta)
+                break;
+        }
+    }
+
+    if (Aborted())
+        return -LARGEINT;
+    return maxval;
+}
+
+// ================================================================
+//                        The endgame solver
+//
+// Once the search goes all the way to the end of the game, the heuristic
+// evaluation is not needed anymore and the only thing that counts is the
+// final score.  The functions below search for it with as few nodes and
+// as little work per node as possible:
+//
+// - In every position the moves that leave the opponent with the fewest
+//   replies are tried first (fastest first).  These are usually the best
+//   moves, and they also make the subtree smallest.
+// - Near the end, moves into regions of the board with an odd number of
+//   empty squares are tried first (parity).  Whoever moves last in a
+//   region usually gains from it.
+// - The last four empty squares are handled by unrolled functions that
+//   don't generate moves at all but just try the squares one by one, and
+//   the very last move is not made but only its flips are counted.
+//
+// The values are final disc differences from the view of the player to
+// move, so they are never outside of -64..64.
+
+
+// The four quadrants of the board, used for the parity ordering.
+static const quint64 QUADRANTS[4] = {
+    0x000000000f0f0f0fULL,
+    0x00000000f0f0f0f0ULL,
+    0x0f0f0f0f00000000ULL,
+    0xf0f0f0f000000000ULL
+};
+
+
+// Return the union of the quadrants with an odd number of empty squares.
+//
+
+static inline quint64 OddQuadrants(quint64 empty)
+{
+    quint64 odd = 0;
+
+    for (int i = 0; i < 4; i++)
+        if (Bitboard::popCount(empty & QUADRANTS[i]) & 1)
+            odd |= QUADRANTS[i];
+
+    return odd;
+}
+
+
+// The hash under which the solver stores positions in the transposition
+// table.  It is computed from scratch, which is cheap enough for the few
+// positions that go into the table.  Each board is mixed on its own
+// first: multiplying them alone leaves the highest bits unmixed, so that
+// positions that only differ in who owns H8 would get the same hash.
+//
+
+static inline quint64 MixBits(quint64 bits)
+{
+    bits ^= bits >> 30;
+    bits *= 0xbf58476d1ce4e5b9ULL;
+    bits ^= bits >> 27;
+    bits *= 0x94d049bb133111ebULL;
+    bits ^= bits >> 31;
+
+    return bits;
+}
+
+static inline quint64 SolverHash(quint64 player, quint64 opponent)
+{
+    return MixBits(player ^ MixBits(opponent + 0x632be59bd9b4e019ULL));
+}
+
+
+// Return the final score of the position with player to move, searched
+// with the window (alpha, beta).  This picks the right solver for the
+// number of empty squares left.
+//
+
+int Engine::Solve(quint64 player, quint64 opponent, int alpha, int beta)
+{
+    const quint64 empty = ~(player | opponent);
+    const int empties = Bitboard::popCount(empty);
+
+    if (empties > 4)
+        return SolveEndgame(player, opponent, alpha, beta, empties);
+
+    // Try the squares alone in their quadrant first.  With at most four
+    // empty squares left, the odd quadrants hold one or three of them.
+    int squares[4];
+    int n = 0;
+    const quint64 odd = OddQuadrants(empty);
+
+    for (quint64 bits = empty & odd; bits; bits &= bits - 1)
+        squares[n++] = Bitboard::firstSquare(bits);
+    for (quint64 bits = empty & ~odd; bits; bits &= bits - 1)
+        squares[n++] = Bitboard::firstSquare(bits);
+
+    switch (empties) {
+    case 4:
+        return SolveFour(player, opponent, alpha, beta,
+                         squares[0], squares[1], squares[2], squares[3]);
+    case 3:
+        return SolveThree(player, opponent, alpha, beta,
+                          squares[0], squares[1], squares[2]);
+    case 2:
+        return SolveTwo(player, opponent, alpha, beta, squares[0], squares[1]);
+    case 1:
+        return SolveOne(player, opponent, squares[0]);
+    default:
+        return Bitboard::popCount(player) - Bitboard::popCount(opponent);
+    }
 }
 
 
-// Calculate bitmaps for each square, and also for neighbors of each
-// square.
+// Solve a position with more than four empty squares.  The first move
+// is searched with the full window and the others only to prove that
+// they are not better (principal variation search).
 //
 
-void Engine::SetupBits()
+int Engine::SolveEndgame(quint64 player, quint64 opponent, int alpha, int beta,
+                         int empties)
 {
-    //m_coord_bit = new long[9][9];
-    //m_neighbor_bits = new long[9][9];
+    // Every now and then see whether we have used up the time or nodes
+    // for this move.
+    if (--m_next_check <= 0) {
+        m_next_check = CHECK_INTERVAL;
+        CheckLimits();
+    }
+
+    const quint64 legal = Bitboard::legalMoves(player, opponent);
+    if (!legal) {
+        if (!Bitboard::legalMoves(opponent, player))
+            return Bitboard::popCount(player) - Bitboard::popCount(opponent);
+        return -SolveEndgame(opponent, player, -beta, -alpha, empties);
+    }
 
-    quint64 bits = 1;
+    const bool use_table = empties >= SOLVER_TABLE_EMPTIES;
+    const quint64 hash = use_table ? SolverHash(player, opponent) : 0;
+    int hash_move = -1;
+
+    TranspositionTable::Entry entry;
+    if (use_table && m_table->probe(hash, entry)) {
+        if (entry.bound == TranspositionTable::Exact
+                || (entry.bound == TranspositionTable::Lower && entry.score >= beta)
+                || (entry.bound == TranspositionTable::Upper && entry.score <= alpha))
+            return entry.score;
+        hash_move = entry.move;
+    }
 
-    // Store a 64 bit unsigned it with the corresponding bit set for
-    // each square.
-    for (int i = 1; i < 9; i++)
-        for (int j = 1; j < 9; j++) {
-            m_coord_bit[i][j] = bits;
-            bits *= 2;
+    // Order the moves.  Far from the end by the number of replies they
+    // leave the opponent, with parity to break ties, and close to the
+    // end by parity alone, which is much cheaper.  The best move found
+    // earlier always goes first.
+    int     squares[60];
+    quint64 flips[60];
+    int     keys[60];
+    int     number_of_moves = 0;
+    const quint64 odd = OddQuadrants(~(player | opponent));
+
+    for (quint64 bits = legal; bits; bits &= bits - 1) {
+        const int square = Bitboard::firstSquare(bits);
+        const quint64 move = Bitboard::squareBit(square);
+        const quint64 turned = Bitboard::flips(square, player, opponent);
+
+        int key;
+        if (square == hash_move)
+            key = -1;
+        else if (empties >= FASTEST_FIRST_EMPTIES)
+            key = 2 * Bitboard::mobility(opponent ^ turned, player ^ turned ^ move)
+                  + !(move & odd);
+        else
+            key = !(move & odd);
+
+        int i = number_of_moves++;
+        for (; i > 0 && keys[i - 1] > key; i--) {
+            squares[i] = squares[i - 1];
+            flips[i]   = flips[i - 1];
+            keys[i]    = keys[i - 1];
         }
+        squares[i] = square;
+        flips[i]   = turned;
+        keys[i]    = key;
+    }
 
-    // Store a bitmap consisting of all neighbors for each square.
-    for (int i = 1; i < 9; i++)
-        for (int j = 1; j < 9; j++) {
-            m_neighbor_bits[i][j] = 0;
+    const int original_alpha = alpha;
+    int maxval = -SOLVER_INFINITY;
+    int max_square = -1;
 
-            for (int xinc = -1; xinc <= 1; xinc++)
-                for (int yinc = -1; yinc <= 1; yinc++) {
-                    if (xinc != 0 || yinc != 0)
-                        if (i + xinc > 0 && i + xinc < 9 && j + yinc > 0 && j + yinc < 9)
-                            m_neighbor_bits[i][j] |= m_coord_bit[i + xinc][j + yinc];
-                }
+    for (int i = 0; i < number_of_moves; i++) {
+        const quint64 new_opponent = player ^ flips[i] ^ Bitboard::squareBit(squares[i]);
+        const quint64 new_player   = opponent ^ flips[i];
+        m_nodes_searched++;
+
+        int val;
+        if (i == 0)
+            val = -Solve(new_player, new_opponent, -beta, -alpha);
+        else {
+            val = -Solve(new_player, new_opponent, -alpha - 1, -alpha);
+            if (val > alpha && val < beta)
+                val = -Solve(new_player, new_opponent, -beta, -alpha);
+        }
+
+        if (Aborted())
+            return 0;
+
+        if (val > maxval) {
+            maxval = val;
+            max_square = squares[i];
+            if (maxval > alpha)
+                alpha = maxval;
+            if (alpha >= beta)
+                break;
         }
+    }
+
+    if (use_table) {
+        TranspositionTable::Bound bound = TranspositionTable::Exact;
+        if (maxval <= original_alpha)
+            bound = TranspositionTable::Upper;
+        else if (maxval >= beta)
+            bound = TranspositionTable::Lower;
+        m_table->store(hash, empties, bound, maxval, max_square);
+    }
+
+    return maxval;
 }
 
 
-// Set up the board control values that will be used in evaluation of
-// the position.
+// Solve a position with the four empty squares sq1..sq4.  Like the
+// functions for three and two empty squares below, this tries the
+// squares in the given order instead of generating the legal moves.
 //
 
-void Engine::SetupBcBoard()
+int Engine::SolveFour(quint64 player, quint64 opponent, int alpha, int beta,
+                      int sq1, int sq2, int sq3, int sq4)
 {
-    // JAVA m_bc_board = new int[9][9];
+    int maxval = -SOLVER_INFINITY;
+    int val;
+    quint64 turned;
+
+    if ((turned = Bitboard::flips(sq1, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveThree(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq1),
+                          -beta, -alpha, sq2, sq3, sq4);
+        if (val >= beta)
+            return val;
+        maxval = val;
+        alpha = qMax(alpha, val);
+    }
 
-    for (int i = 1; i < 9; i++)
-        for (int j = 1; j < 9; j++) {
-            if (i == 2 || i == 7)
-                m_bc_board[i][j] = -1;
-            else
-                m_bc_board[i][j] = 0;
+    if ((turned = Bitboard::flips(sq2, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveThree(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq2),
+                          -beta, -alpha, sq1, sq3, sq4);
+        if (val >= beta)
+            return val;
+        maxval = qMax(maxval, val);
+        alpha = qMax(alpha, val);
+    }
 
-            if (j == 2 || j == 7)
-                m_bc_board[i][j] -= 1;
-        }
+    if ((turned = Bitboard::flips(sq3, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveThree(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq3),
+                          -beta, -alpha, sq1, sq2, sq4);
+        if (val >= beta)
+            return val;
+        maxval = qMax(maxval, val);
+        alpha = qMax(alpha, val);
+    }
+
+    if ((turned = Bitboard::flips(sq4, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveThree(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq4),
+                          -beta, -alpha, sq1, sq2, sq3);
+        maxval = qMax(maxval, val);
+    }
+
+    if (maxval > -SOLVER_INFINITY)
+        return maxval;
 
-    m_bc_board[1][1] = 2;
-    m_bc_board[8][1] = 2;
-    m_bc_board[1][8] = 2;
-    m_bc_board[8][8] = 2;
+    // No move for player: the opponent moves again, or the game is over.
+    if (Bitboard::flips(sq1, opponent, player) || Bitboard::flips(sq2, opponent, player)
+            || Bitboard::flips(sq3, opponent, player) || Bitboard::flips(sq4, opponent, player))
+        return -SolveFour(opponent, player, -beta, -alpha, sq1, sq2, sq3, sq4);
 
-    m_bc_board[1][2] = -1;
-    m_bc_board[2][1] = -1;
-    m_bc_board[1][7] = -1;
-    m_bc_board[7][1] = -1;
-    m_bc_board[8][2] = -1;
-    m_bc_board[2][8] = -1;
-    m_bc_board[8][7] = -1;
-    m_bc_board[7][8] = -1;
+    return Bitboard::popCount(player) - Bitboard::popCount(opponent);
 }
 
 
-// Calculate the board control score.
+// Solve a position with the three empty squares sq1..sq3.
 //
 
-int Engine::CalcBcScore(ChipColor color)
+int Engine::SolveThree(quint64 player, quint64 opponent, int alpha, int beta,
+                       int sq1, int sq2, int sq3)
 {
-    int sum = 0;
+    int maxval = -SOLVER_INFINITY;
+    int val;
+    quint64 turned;
+
+    if ((turned = Bitboard::flips(sq1, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveTwo(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq1),
+                        -beta, -alpha, sq2, sq3);
+        if (val >= beta)
+            return val;
+        maxval = val;
+        alpha = qMax(alpha, val);
+    }
+
+    if ((turned = Bitboard::flips(sq2, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveTwo(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq2),
+                        -beta, -alpha, sq1, sq3);
+        if (val >= beta)
+            return val;
+        maxval = qMax(maxval, val);
+        alpha = qMax(alpha, val);
+    }
+
+    if ((turned = Bitboard::flips(sq3, player, opponent))) {
+        m_nodes_searched++;
+        val = -SolveTwo(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq3),
+                        -beta, -alpha, sq1, sq2);
+        maxval = qMax(maxval, val);
+    }
+
+    if (maxval > -SOLVER_INFINITY)
+        return maxval;
+
+    if (Bitboard::flips(sq1, opponent, player) || Bitboard::flips(sq2, opponent, player)
+            || Bitboard::flips(sq3, opponent, player))
+        return -SolveThree(opponent, player, -beta, -alpha, sq1, sq2, sq3);
+
+    return Bitboard::popCount(player) - Bitboard::popCount(opponent);
+}
+
+
+// Solve a position with the two empty squares sq1 and sq2.
+//
+
+int Engine::SolveTwo(quint64 player, quint64 opponent, int alpha, int beta,
+                     int sq1, int sq2)
+{
+    int maxval = -SOLVER_INFINITY;
+    quint64 turned;
+
+    if ((turned = Bitboard::flips(sq1, player, opponent))) {
+        m_nodes_searched++;
+        maxval = -SolveOne(opponent ^ turned, player ^ turned ^ Bitboard::squareBit(sq1), sq2);
+        if (maxval >= beta)
+            return maxval;
+    }
+
+    if ((turned = Bitboard::flips(sq2, player, opponent))) {
+        m_nodes_searched++;
+        maxval = qMax(maxval, -SolveOne(opponent ^ turned,
+                                        player ^ turned ^ Bitboard::squareBit(sq2), sq1));
+    }
+
+    if (maxval > -SOLVER_INFINITY)
+        return maxval;
+
+    if (Bitboard::flips(sq1, opponent, player) || Bitboard::flips(sq2, opponent, player))
+        return -SolveTwo(opponent, player, -beta, -alpha, sq1, sq2);
+
+    return Bitboard::popCount(player) - Bitboard::popCount(opponent);
+}
+
+
+// Return the final score when only the square sq is empty.  The move is
+// not made, it is enough to know how many pieces it turns.
+//
+
+int Engine::SolveOne(quint64 player, quint64 opponent, int sq)
+{
+    const int score = Bitboard::popCount(player) - Bitboard::popCount(opponent);
+    int turned;
+
+    if ((turned = Bitboard::countFlips(sq, player, opponent))) {
+        m_nodes_searched++;
+        return score + 2 * turned + 1;
+    }
 
-    for (int i = 1; i < 9; i++)
-        for (int j = 1; j < 9; j++)
-            if (m_board[i][j] == color)
-                sum += m_bc_board[i][j];
+    if ((turned = Bitboard::countFlips(sq, opponent, player))) {
+        m_nodes_searched++;
+        return score - 2 * turned - 1;
+    }
 
-    return sum;
+    return score;
 }
 
 
-// Calculate a bitmap of the occupied squares for a certain color.
+// The moves the search expects after color plays square, starting with
+// that move.  They are the best moves stored in the transposition table
+// for the positions on the way, as far as the search went.  The last
+// few moves of a solved game are never stored, and others may have been
+// replaced since, so those are searched again.
 //
 
-quint64 Engine::ComputeOccupiedBits(ChipColor color)
+MoveList Engine::Variation(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                           int square)
 {
-    quint64 retval = 0;
+    MoveList variation;
+
+    while (square >= 0) {
+        variation.append(KReversiMove(color, square / 8, square % 8));
+
+        const quint64 flips = Bitboard::flips(square, colorbits, opponentbits);
+        colorbits    ^= flips | Bitboard::squareBit(square);
+        opponentbits ^= flips;
+
+        // It is the opponent's turn, unless they have to pass.
+        if (Bitboard::legalMoves(opponentbits, colorbits)) {
+            qSwap(colorbits, opponentbits);
+            color = Utils::opponentColorFor(color);
+        }
+
+        const quint64 legal = Bitboard::legalMoves(colorbits, opponentbits);
+        if (!legal)
+            break;
 
-    for (int i = 1; i < 9; i++)
-        for (int j = 1; j < 9; j++)
-            if (m_board[i][j] == color) retval |= m_coord_bit[i][j];
+        TranspositionTable::Entry entry;
+        square = -1;
+        if (m_exhaustive) {
+            if (Bitboard::popCount(~(colorbits | opponentbits)) >= SOLVER_TABLE_EMPTIES
+                    && m_table->probe(SolverHash(colorbits, opponentbits), entry)
+                    && entry.move >= 0 && (legal & Bitboard::squareBit(entry.move)))
+                square = entry.move;
+            else {
+                int maxval = -SOLVER_INFINITY - 1;
+                for (quint64 bits = legal; bits; bits &= bits - 1) {
+                    const int move = Bitboard::firstSquare(bits);
+                    const quint64 turned = Bitboard::flips(move, colorbits, opponentbits);
+                    const int val = -Solve(opponentbits ^ turned,
+                                           colorbits ^ turned ^ Bitboard::squareBit(move),
+                                           -SOLVER_INFINITY, -qMax(maxval, -SOLVER_INFINITY));
+                    if (val > maxval) {
+                        maxval = val;
+                        square = move;
+                    }
+                }
+            }
+        } else if (variation.size() < m_depth
+                   && m_table->probe(ComputeHash(color, colorbits, opponentbits), entry)
+                   && entry.move >= 0 && (legal & Bitboard::squareBit(entry.move)))
+            square = entry.move;
+    }
 
-    return retval;
+    return variation;
 }
 
+
+// Calculate a heuristic value for the current position, after a move
+// by Color: look up the value in the evaluation tables.  It is the
+// opponent's turn, so the tables give the value for the opponent.  An
+// exhaustive search never gets here, the endgame solver takes over
+// before.
+//
+
+template<ChipColor Color>
+int Engine::EvaluatePosition()
+{
+    return -m_patterns.evaluate<(Color == White) ? Black : White>();
+}
+
+
+// Calculate the hash of a position from scratch.  Heuristic and
+// exhaustive search results are kept apart, since their values are
+// not comparable.  So are the heuristic results of each strength: the
+// table may be shared with other engines (see setTable()), and an easy
+// engine should not play the moves a deeper search found for a harder
+// one.
+//
+
+quint64 Engine::ComputeHash(ChipColor color, quint64 colorbits, quint64 opponentbits)
+{
+    ChipColor opponent = Utils::opponentColorFor(color);
+    quint64 hash = 0;
+
+    for (; colorbits; colorbits &= colorbits - 1)
+        hash ^= ZOBRIST.piece[color][Bitboard::firstSquare(colorbits)];
+    for (; opponentbits; opponentbits &= opponentbits - 1)
+        hash ^= ZOBRIST.piece[opponent][Bitboard::firstSquare(opponentbits)];
+
+    if (color == White)
+        hash ^= ZOBRIST.side;
+    if (m_exhaustive)
+        hash ^= ZOBRIST.exhaustive;
+    else
+        hash ^= ZOBRIST.strength[qBound(0, int(m_strength), MAX_STRENGTH)];
+
+    return hash;
+}
@@ -27,73 +27,87 @@
  * look at http://www.luthman.nu/Othello/Othello.html
  */
 
-// The class Engine produces moves from a Game object through calls to the
-// function ComputeMove().
+// The class Engine produces moves for a Position (two bitboards and the
+// player to move) through calls to computeMove(const Position&, bool), or
+// startComputeMove() to search on a thread of its own.  It only needs
+// QtCore, so tools can link the engine library without the game.
 //
-// First of all: this is meant to be a simple example of a game playing
-// program. Not everything is done in the most clever way, particularly not
-// the way the moves are searched, but it is hopefully made in a way that makes
-// it easy to understand. The function ComputeMove2() that does all the work
-// is actually not much more than a hundred lines. Much could be done to
-// make the search faster though, I'm perfectly aware of that. Feel free
-// to experiment.
-//
-// The method used to generate the moves is called minimax tree search with
-// alpha-beta pruning to a fixed depth. In short this means that all possible
-// moves a predefined number of moves ahead are either searched or refuted
-// with a method called alpha-beta pruning. A more thorough explanation of
-// this method could be found at the world wide web at
-// https://cis.temple.edu/~ingargio/cis587/readings/alpha-beta.html
-// at the time this was written. Searching for "minimax" would also point
-// you to information on this subject. It is probably possible to understand
-// this method by reading the source code though, it is not that complicated.
+// The moves are found by an alpha-beta search (ComputeMove2() and
+// TryAllMoves()), with a version for each color to move and for
+// heuristic and exhaustive search, so that neither is asked again at
+// every node.  How far it looks ahead is set by the iterative deepening
+// described below (m_depth).  The moves of a position are tried in the
+// order most likely to cut the search off early: the best move stored
+// in the transposition table, the killer moves of the level, then the
+// others by their history and, far enough from the leaves, by the
+// replies they leave the opponent (see OrderMoves()).  The endgame
+// solver (SolveEndgame()) and analyze() (AnalyzeMoves()) search the
+// first move with the full window and the others with a null window,
+// and a move again only if it turns out better (principal variation
+// search).
 //
 // At every leaf node at the search tree, the resulting position is evaluated.
-// Two things are considered when evaluating a position: the number of pieces
-// of each color and at which squares the pieces are located. Pieces at the
-// corners are valuable and give a high value, and having pieces at squares
-// next to a corner is not very good and they give a lower value. In the
-// beginning of a game it is more important to have pieces on "good" squares,
-// but towards the end the total number of pieces of each color is given a
-// higher weight. Other things, like how many legal moves that can be made in a
-// position, and the number of pieces that can never be turned would probably
-// make the program stronger if they were considered in evaluating a position,
-// but that would make things more complicated (this was meant to be very
-// simple example) and would also slow down computation (considerably?).
+// This is done by looking at the edges, the corners and the diagonals of
+// the board: for each of them a table gives the value of every way the
+// pieces could be placed on it (see class PatternEvaluator). The tables were
+// fitted to the results of many games, so they know things like which edge
+// pieces can never be turned and when a square next to a corner gives the
+// corner away. What makes a position good is not the same in the opening as
+// close to the end, so there is a separate set of tables for each stage of
+// the game.
+//
+// The position during the computation is held in two 64 bit masks, one
+// for the pieces of the color to move and one for the opponent (see
+// bitboard.h). They are set up at the start of ComputeMove() and passed
+// down the search by value. The legal moves of a position are generated
+// for all squares at once by shifting and masking the two boards, and the
+// pieces turned by a move are computed as a single mask. Making a move is
+// then just an XOR of that mask (plus the new piece) into both boards, and
+// since every level of the search works on its own copy, taking the move
+// back again costs nothing at all.
+//
+// Many positions are reached through different move orders, so every
+// position searched is remembered in m_table (see class TranspositionTable)
+// under a Zobrist hash: the XOR of one random number per piece and square,
+// which is updated together with the bitboards when a move is made. The
+// table is kept between calls to ComputeMove(), so a position that was
+// already searched one move earlier is not searched all over again. The
+// best move stored for a position is always tried first, the others
+// after it in the order of OrderMoves().
 //
-// The member m_board[10][10]) holds the current position during the
-// computation. It is initiated at the start of ComputeMove() and
-// every move that is made during the search is made on this board. It should
-// be noted that 1 to 8 is used for the actual board, but 0 and 9 can be
-// used too (they are always empty). This is practical when turning pieces
-// when moves are made on the board. Every piece that is put on the board
-// or turned is saved in the stack m_squarestack (see class SquareStack) so
-// every move can easily be reversed after the search in a node is completed.
+// The search itself uses iterative deepening: first all moves are searched
+// one level deep, then two levels deep and so on, until the depth allowed by
+// the strength is reached or the time for the move is used up (see
+// STRENGTH_LIMITS). Every search tries the moves in the order of the values
+// the previous one found, which together with the transposition table
+// makes the deeper searches a lot cheaper. If the time runs out in the
+// middle of a search, the move found by the last complete one is played.
+// This keeps the time the computer needs for a move about the same on any
+// machine and in any position.
 //
-// The member m_bc_board[][] holds board control values for each square
-// and is initiated by a call to the function private void SetupBcBoard()
-// from Engines constructor. It is used in evaluation of positions except
-// when the game tree is searched all the way to the end of the game.
+// In competitive games the opening moves are taken from an opening book
+// (see class OpeningBook) as long as the position is in it, without any
+// search at all.
 //
-// The two members m_coord_bit[9][9] and m_neighbor_bits[9][9] are used to
-// speed up the tree search. This goes against the principle of keeping things
-// simple, but to understand the program you do not need to understand them
-// at all. They are there to make it possible to throw away moves where
-// the piece that is played is not adjacent to a piece of opposite color
-// at an early stage (because they could never be legal). It should be
-// pointed out that not all moves that pass this test are legal, there will
-// just be fewer moves that have to be tested in a more time consuming way.
+// Close to the end of the game the search goes all the way to the end
+// (see StrengthLimits::solve). The positions are then no longer evaluated
+// but solved exactly by a separate, much faster endgame solver (see
+// Solve()), first only to find out whether the moves win, draw or lose
+// and then for the exact score.
+//
+// On machines with more than one core, helper engines search the same
+// position on other threads at the same time (see StartHelpers()). They
+// share the transposition table with the main search, which then finds
+// many positions already searched for it. The table can be used by all
+// threads at once without locks.
 //
 // There are also two other members that should be mentioned: Score m_score
-// and Score m_bc_score. They hold the number of pieces of each color and
-// the sum of the board control values for each color during the search
-// (this is faster than counting at every leaf node).
+// and PatternEvaluator m_patterns. They hold the number of pieces of each
+// color and the indices into the evaluation tables during the search, and
+// are updated when a move is made and taken back (this is faster than
+// looking at the whole board at every leaf node).
 //
 
-// The classes SquareStackEntry and SquareStack implement a
-// stack that is used by Engine to store pieces that are turned during
-// searching (see ComputeMove()).
-//
 // The class MoveAndValue is used by Engine to store all possible moves
 // at the first level and the values that were calculated for them.
 // This makes it possible to select a random move among those with equal
@@ -102,66 +116,79 @@
 #ifndef KREVERSI_ENGINE_H
 #define KREVERSI_ENGINE_H
 
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QRandomGenerator>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
 
-#include "commondefs.h"
-#include "kreversigame.h"
-class KReversiGame;
+#include "bitboard.h"
+#include "kreversimove.h"
+#include "openingbook.h"
+#include "patternevaluator.h"
+#include "position.h"
+#include "transpositiontable.h"
 
 
-// SquareStackEntry and SquareStack are used during search to keep
-// track of turned pieces.
+// Connect a move with its value.
 
-class SquareStackEntry
+class MoveAndValue
 {
 public:
-    SquareStackEntry();
+    MoveAndValue();
+    MoveAndValue(int square, int value);
 
-    void setXY(int x, int y);
+    void  setSV(int square, int value);
 
 public:
-    int  m_x;
-    int  m_y;
+    int  m_square;
+    int  m_value;
 };
 
+// This class keeps track of the score for both colors.  Such a score
+// could be either the number of pieces, the score from the evaluation
+// function or anything similar.
 
-class SquareStack
+class Score
 {
 public:
-    SquareStack();
-    explicit SquareStack(int size);
-
-    void              resize(int size);
-    void              init(int size);
-    SquareStackEntry  Pop();
-    void              Push(int x, int y);
-
-private:
-    QVector<SquareStackEntry>  m_squarestack;
-    int                          m_top;
-};
-
-
-// Connect a move with its value.
+    Score() {
+        m_score[White] = 0;
+        m_score[Black] = 0;
+    }
 
-class MoveAndValue
-{
-public:
-    MoveAndValue();
-    MoveAndValue(int x, int y, int value);
+    uint score(ChipColor color) const     {
+        return m_score[color];
+    }
 
-    void  setXYV(int x, int y, int value);
+    void set(ChipColor color, uint score) {
+        m_score[color] = score;
+    }
+    void inc(ChipColor color)             {
+        m_score[color]++;
+    }
+    void dec(ChipColor color)             {
+        m_score[color]--;
+    }
+    void add(ChipColor color, uint s)     {
+        m_score[color] += s;
+    }
+    void sub(ChipColor color, uint s)     {
+        m_score[color] -= s;
+    }
 
-public:
-    int  m_x;
-    int  m_y;
-    int  m_value;
+private:
+    uint  m_score[2];
 };
 
-class Score;
-
 // The real beef of this program: the engine that finds good moves for
-// the computer player.
+// the computer player.  computeMove() searches on the calling thread,
+// startComputeMove() on a search thread owned by the engine, so that the
+// GUI stays responsive while the computer is thinking.
 //
 class Engine
 {
@@ -172,63 +199,228 @@ public:
 
     ~Engine();
 
-    KReversiMove     computeMove(const KReversiGame& game, bool competitive);
+    KReversiMove     computeMove(const Position& position, bool competitive);
+    QFuture<KReversiMove> startComputeMove(const Position& position, bool competitive);
+
+    // Pondering: thinking on the opponent's time.  startPonder() gets
+    // the position after our own move and searches on for as long as it
+    // takes the opponent to reply, until interrupted.  If the reply is
+    // the one the engine expected, ponderPosition() is the position the
+    // opponent has left us and ponderHit() turns the search into a normal
+    // one, which has used up its time already if the opponent took long
+    // enough.  Otherwise the search is thrown away, but the transposition
+    // table it filled makes the next search a lot faster.
+    QFuture<KReversiMove> startPonder(const Position& position, bool competitive);
+    Position ponderPosition() const {
+        return m_ponder_position;
+    }
+    void  ponderHit();
     bool isThinking() const {
         return m_computingMove;
     }
 
     void  setInterrupt(bool intr) {
         m_interrupt = intr;
+        for (Engine *helper : qAsConst(m_helpers))
+            helper->setInterrupt(intr);
     }
     bool  interrupted() const     {
         return m_interrupt;
     }
 
+    // Unlike an interrupt, which throws the search away, stop() ends it
+    // as if the time were up: the move found so far is returned.
+    void  stop() {
+        m_stop = true;
+        for (Engine *helper : qAsConst(m_helpers))
+            helper->stop();
+    }
+
+    // Undo setInterrupt() and stop() before the next search.
+    // startComputeMove() and startPonder() do this themselves, but
+    // computeMove() and analyze() don't.  Whoever runs those on another
+    // thread calls this before handing the search over, so that an
+    // interrupt or stop that comes before the search has started is not
+    // lost.
+    void  clearInterrupt() {
+        setInterrupt(false);
+        m_stop = false;
+        for (Engine *helper : qAsConst(m_helpers))
+            helper->m_stop = false;
+    }
+
     void  setStrength(uint strength) {
         m_strength = strength;
+        for (Engine *helper : qAsConst(m_helpers))
+            helper->setStrength(strength);
     }
     uint  strength() const {
         return m_strength;
     }
-private:
-    KReversiMove     ComputeFirstMove(const KReversiGame& game);
-    int      ComputeMove2(int xplay, int yplay, ChipColor color, int level,
-                          int      cutoffval,
-                          quint64  colorbits, quint64 opponentbits);
 
-    int      TryAllMoves(ChipColor opponent, int level, int cutoffval,
-                         quint64  opponentbits, quint64 colorbits);
+    // Called on the search thread every time a search one level deeper
+    // has been completed, with the position searched, the best move so
+    // far and the depth it was found at.  Only set it while the engine
+    // is not searching.
+    typedef std::function<void(const Position&, const KReversiMove&, int)> ProgressHandler;
+    void  setProgressHandler(const ProgressHandler &handler) {
+        m_progress = handler;
+    }
 
-    int      EvaluatePosition(ChipColor color);
-    void     SetupBcBoard();
-    void     SetupBits();
-    int      CalcBcScore(ChipColor color);
-    quint64  ComputeOccupiedBits(ChipColor color);
+    void  setTimeLimit(int msecs);
+    void  setNodeLimit(qint64 nodes);
+    void  setDepthLimit(int depth);
+    void  setHashTableSize(int megabytes);
+    void  setTable(const QSharedPointer<TranspositionTable> &table);
+    void  setThreads(int threads);
+    bool  setOpeningBook(const QString &fileName);
+
+    // What the last call to computeMove() found out: the number of
+    // positions searched by all threads, and the value of the move (in
+    // hundredths of a chip) as found by the deepest complete search.
+    qint64 nodesSearched() const;
+    int   moveValue() const {
+        return m_move_value;
+    }
+    int   moveDepth() const {
+        return m_move_depth;
+    }
+    bool  moveExact() const {
+        return m_move_exact;
+    }
 
-    void yield();
+    // What analyze() found out about a move: its value (in hundredths of
+    // a chip, for the player to move), the depth it was searched to,
+    // whether the value is the final result of the game, and the moves
+    // the search expects to be played, starting with this one.  When a
+    // player has to pass, the other player simply moves twice in a row.
+    struct MoveAnalysis {
+        KReversiMove move;
+        int          value;
+        int          depth;
+        bool         exact;
+        MoveList     variation;
+    };
+
+    // Search position like computeMove() does, within the same limits,
+    // but find the real values of the best count moves, or of all of
+    // them if count is 0, and not just which one is best.  The moves are
+    // returned best first.  With more than one thread, the moves are
+    // searched in parallel.
+    QVector<MoveAnalysis> analyze(const Position& position, int count = 0);
+private:
+    struct RootMoves;
+
+    KReversiMove     ComputeMove(ChipColor color, quint64 colorbits, quint64 opponentbits);
+    KReversiMove     ComputeFirstMove(ChipColor color);
+    KReversiMove     ComputeBookMove(ChipColor color, quint64 book_moves);
+    int      ComputeMove2(int square, ChipColor color, int level,
+                          int      alpha, int beta,
+                          quint64  colorbits, quint64 opponentbits,
+                          quint64  hash);
+    template<ChipColor Color, bool Exhaustive>
+    int      ComputeMove2(int square, int level, int alpha, int beta,
+                          quint64 colorbits, quint64 opponentbits, quint64 hash);
+
+    int      SearchLimits(int discs);
+    int      SearchRoot(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                        MoveAndValue *moves, int number_of_moves);
+    bool     AnalyzeRoot(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                         MoveAndValue *moves, int number_of_moves, int count);
+    void     AnalyzeMoves(RootMoves &root);
+    MoveList Variation(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                       int square);
+    int      CollectMoves(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                          MoveAndValue *moves);
+    void     StartHelpers(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                          int max_depth);
+    void     StopHelpers();
+    void     HelpSearch(ChipColor color, quint64 colorbits, quint64 opponentbits,
+                        int first_depth, int max_depth);
+
+    template<ChipColor Color>
+    int      TryAllMoves(int level, int alpha, int beta,
+                         quint64 colorbits, quint64 opponentbits, quint64 hash);
+    template<ChipColor Color>
+    int      TryLeafMoves(int alpha, int beta, quint64 colorbits, quint64 opponentbits);
+    template<ChipColor Color>
+    int      OrderMoves(int level, int depth, quint64 colorbits, quint64 opponentbits,
+                        quint64 legal, int *squares, int *keys) const;
+    template<ChipColor Color>
+    void     RememberCutoff(int level, int depth, int square);
+    void     StartMoveOrdering();
+    int      NextDepth(int depth, int max_depth) const;
+
+    int      Solve(quint64 player, quint64 opponent, int alpha, int beta);
+    int      SolveEndgame(quint64 player, quint64 opponent, int alpha, int beta,
+                          int empties);
+    int      SolveFour(quint64 player, quint64 opponent, int alpha, int beta,
+                       int sq1, int sq2, int sq3, int sq4);
+    int      SolveThree(quint64 player, quint64 opponent, int alpha, int beta,
+                        int sq1, int sq2, int sq3);
+    int      SolveTwo(quint64 player, quint64 opponent, int alpha, int beta,
+                      int sq1, int sq2);
+    int      SolveOne(quint64 player, quint64 opponent, int sq);
+
+    template<ChipColor Color>
+    int      EvaluatePosition();
+    quint64  ComputeHash(ChipColor color, quint64 colorbits, quint64 opponentbits);
+
+    Position PonderPosition(const Position& position);
+    void     EnsureTable();
+    qint64   TimeUsed() const;
+    void CheckLimits();
+    bool Aborted() const {
+        return m_interrupt || m_out_of_time;
+    }
 
 private:
 
-    ChipColor        m_board[10][10];
-    int          m_bc_board[9][9];
-    Score*        m_score;
-    Score*        m_bc_score;
-    SquareStack  m_squarestack;
+    Score         m_score;
+    PatternEvaluator m_patterns;
 
     int          m_depth;
-    int          m_coeff;
-    int          m_nodes_searched;
+    int          m_search_time;
+    int          m_next_check;
+    bool         m_out_of_time;
+    QElapsedTimer m_timer;
+    qint64       m_nodes_searched;
     bool         m_exhaustive;
+    bool         m_solve;
+    bool         m_wld;
     bool         m_competitive;
 
+    // The move ordering of TryAllMoves(): for every level of the search
+    // the last two moves that caused a cutoff there (the killer moves,
+    // or -1), and for every color and square a value that grows each
+    // time a move there causes a cutoff (the history).
+    int          m_killers[60][2];
+    int          m_history[2][64];
+
     uint             m_strength;
     QRandomGenerator m_random;
-    bool             m_interrupt;
+    int              m_time_limit;
+    qint64           m_node_limit;
+    int              m_depth_limit;
+    std::atomic<bool> m_interrupt;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_pondering;
+    Position          m_ponder_position;
+
+    QSharedPointer<TranspositionTable> m_table;
+
+    OpeningBook  m_book;
+
+    int          m_move_value;
+    int          m_move_depth;
+    bool         m_move_exact;
+    ProgressHandler m_progress;
 
-    quint64      m_coord_bit[9][9];
-    quint64      m_neighbor_bits[9][9];
+    std::atomic<bool> m_computingMove;
+    QThreadPool       m_search_thread;
 
-    bool m_computingMove;
+    QVector<Engine*>  m_helpers;
+    QThreadPool       m_helper_threads;
 };
 
 #endif
@@ -0,0 +1,14 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "allocationcounter.h"
+
+#ifndef QT_NO_DEBUG
+
+// Set by countallocations.cpp in the programs that link it in.
+quint64 (*NoAllocations::counter)() = nullptr;
+
+#endif
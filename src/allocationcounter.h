@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_ALLOCATIONCOUNTER_H
+#define KREVERSI_ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+ *  Asserts that the thread it lives on allocates no memory from its
+ *  construction to its destruction. The search puts one around the work
+ *  it does for every move and every level of iterative deepening, so
+ *  that it stays free of allocations.
+ *
+ *  The engine does not count allocations itself, so that the game and
+ *  the tools allocate as usual. A program that wants them checked links
+ *  in countallocations.cpp, which replaces malloc() and friends with
+ *  versions that count per thread and sets @ref counter. Without it, and
+ *  in builds without assertions, this class does nothing.
+ */
+class NoAllocations
+{
+public:
+#ifndef QT_NO_DEBUG
+    NoAllocations() : m_start(counter ? counter() : 0) {}
+    ~NoAllocations() {
+        Q_ASSERT_X(!counter || counter() == m_start, "NoAllocations", "memory was allocated");
+    }
+
+    /**
+     *  Returns the number of times the current thread has allocated
+     *  memory so far, or is null if allocations are not counted. Set
+     *  before main() starts and never changed afterwards.
+     */
+    static quint64 (*counter)();
+
+private:
+    quint64 m_start;
+#else
+    // not trivial, so that the guards don't count as unused variables
+    NoAllocations() {}
+#endif
+};
+
+#endif
@@ -0,0 +1,225 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// kreversi-bench: lets the engine search a fixed set of positions and
+// reports, as JSON, how many positions it searched and how fast, so that
+// the speed of different builds can be compared.
+//
+// The positions are read in the format of the FFO endgame test suite
+// (.obf files, see obf.h), one per line. Empty lines and lines starting
+// with '#' or '%' are skipped.
+//
+// The "benchmark" target runs the positions in benchmark-midgame.obf
+// and benchmark-endgame.obf. The midgame positions are searched to
+// --depth moves, positions with at most 20 empty squares are solved
+// exactly. The FFO set itself (fforum-40-59.obf and friends) can be
+// given on the command line; use --depth 60 to solve those too.
+//
+// The "benchmark-threads" target runs the same positions with 1, 2, 4, 8
+// and 16 threads. The total msecs of each report is the time to depth
+// with that many threads. Run it on a machine with at least 16 cores,
+// since more threads than cores can only slow the search down.
+//
+// The transposition table is cleared before each position, and the
+// engine always starts with the same random numbers, so with one
+// thread the number of positions searched only changes when the search
+// does.
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <limits>
+
+#include "Engine.h"
+#include "bitboard.h"
+#include "obf.h"
+
+namespace
+{
+
+// The strength the positions are searched with.  Its time limit is
+// replaced, so this only decides which positions are solved.
+const int BENCH_STRENGTH = 6;
+
+struct Entry {
+    QString  file;
+    int      line;
+    QString  name;
+    Position position;
+};
+
+// Reads one line of an .obf file into entry.
+bool parseEntry(const QString &line, Entry &entry, QString &error)
+{
+    if (!Obf::parse(line, entry.position, entry.name, error))
+        return false;
+
+    if (!Bitboard::legalMoves(entry.position.player(), entry.position.opponent())) {
+        error = QStringLiteral("the player to move has no moves");
+        return false;
+    }
+    return true;
+}
+
+QString squareName(const KReversiMove &move)
+{
+    if (!move.isValid())
+        return QString();
+    return QString(QLatin1Char(char('a' + move.col))) + QLatin1Char(char('1' + move.row));
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kreversi-bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures the speed of the KReversi engine."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("positions"), QStringLiteral("Files with one position per line (.obf)."),
+                                 QStringLiteral("positions..."));
+    const QCommandLineOption outputOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"),
+                                          QStringLiteral("Write the results to <file> instead of the standard output."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption depthOption(QStringLiteral("depth"),
+                                         QStringLiteral("Search <moves> moves ahead."),
+                                         QStringLiteral("moves"), QStringLiteral("10"));
+    const QCommandLineOption timeOption(QStringLiteral("time"),
+                                        QStringLiteral("Stop searching a position after <msecs> milliseconds (0: never)."),
+                                        QStringLiteral("msecs"), QStringLiteral("0"));
+    const QCommandLineOption hashOption(QStringLiteral("hash"),
+                                        QStringLiteral("Use <megabytes> for the transposition table."),
+                                        QStringLiteral("megabytes"), QStringLiteral("64"));
+    const QCommandLineOption threadsOption(QStringLiteral("threads"),
+                                           QStringLiteral("Search with <count> threads."),
+                                           QStringLiteral("count"), QStringLiteral("1"));
+    parser.addOption(outputOption);
+    parser.addOption(depthOption);
+    parser.addOption(timeOption);
+    parser.addOption(hashOption);
+    parser.addOption(threadsOption);
+    parser.process(application);
+
+    const QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty())
+        parser.showHelp(1);
+
+    const int depth = qBound(1, parser.value(depthOption).toInt(), 60);
+    const int msecs = parser.value(timeOption).toInt();
+    const int hash = parser.value(hashOption).toInt();
+    const int threads = qMax(parser.value(threadsOption).toInt(), 1);
+
+    QTextStream err(stderr);
+    QVector<Entry> entries;
+
+    for (const QString &input : inputs) {
+        QFile file(input);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            err << input << ": " << file.errorString() << '\n';
+            return 1;
+        }
+
+        QTextStream in(&file);
+        for (int lineNumber = 1; !in.atEnd(); ++lineNumber) {
+            const QString line = in.readLine();
+            if (line.trimmed().isEmpty() || line.startsWith(QLatin1Char('#'))
+                    || line.startsWith(QLatin1Char('%')))
+                continue;
+
+            Entry entry;
+            QString error;
+            if (!parseEntry(line, entry, error)) {
+                err << input << ':' << lineNumber << ": " << error << ", skipped\n";
+                continue;
+            }
+            entry.file = QFileInfo(input).fileName();
+            entry.line = lineNumber;
+            entries.append(entry);
+        }
+    }
+
+    Engine engine(BENCH_STRENGTH, 1);
+    engine.setDepthLimit(depth);
+    engine.setTimeLimit(msecs > 0 ? msecs : std::numeric_limits<int>::max());
+    engine.setThreads(threads);
+
+    QJsonArray results;
+    qint64 totalNodes = 0;
+    qint64 totalNsecs = 0;
+
+    for (const Entry &entry : qAsConst(entries)) {
+        engine.setHashTableSize(hash);
+
+        QElapsedTimer timer;
+        timer.start();
+        const KReversiMove move = engine.computeMove(entry.position, true);
+        const qint64 nsecs = qMax(timer.nsecsElapsed(), qint64(1));
+
+        const qint64 nodes = engine.nodesSearched();
+        totalNodes += nodes;
+        totalNsecs += nsecs;
+
+        QJsonObject result;
+        result[QStringLiteral("file")] = entry.file;
+        result[QStringLiteral("line")] = entry.line;
+        if (!entry.name.isEmpty())
+            result[QStringLiteral("name")] = entry.name;
+        result[QStringLiteral("empties")] = 64 - Bitboard::popCount(entry.position.black | entry.position.white);
+        result[QStringLiteral("move")] = squareName(move);
+        result[QStringLiteral("score")] = engine.moveValue() / 100.0;
+        result[QStringLiteral("exact")] = engine.moveExact();
+        result[QStringLiteral("depth")] = engine.moveDepth();
+        result[QStringLiteral("nodes")] = nodes;
+        result[QStringLiteral("msecs")] = nsecs / 1e6;
+        result[QStringLiteral("nps")] = qRound64(nodes * 1e9 / nsecs);
+        results.append(result);
+
+        err << entry.file << ':' << entry.line << ' ' << squareName(move) << ' '
+            << engine.moveValue() / 100.0 << ' ' << nodes << " nodes " << nsecs / 1000000 << " ms\n";
+        err.flush();
+    }
+
+    QJsonObject settings;
+    settings[QStringLiteral("depth")] = depth;
+    settings[QStringLiteral("time")] = msecs;
+    settings[QStringLiteral("hash")] = hash;
+    settings[QStringLiteral("threads")] = threads;
+    settings[QStringLiteral("kernels")] = QLatin1String(Bitboard::kernels.name);
+
+    QJsonObject total;
+    total[QStringLiteral("positions")] = entries.size();
+    total[QStringLiteral("nodes")] = totalNodes;
+    total[QStringLiteral("msecs")] = totalNsecs / 1e6;
+    total[QStringLiteral("nps")] = qRound64(totalNodes * 1e9 / qMax(totalNsecs, qint64(1)));
+
+    QJsonObject report;
+    report[QStringLiteral("settings")] = settings;
+    report[QStringLiteral("positions")] = results;
+    report[QStringLiteral("total")] = total;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QSaveFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+            err << parser.value(outputOption) << ": cannot write the results\n";
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
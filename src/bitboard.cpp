@@ -0,0 +1,254 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "bitboard.h"
+
+// The vector kernels need the target attribute and __builtin_cpu_supports()
+// of GCC and Clang, so that one binary can carry code for CPUs it may not
+// run on. With other compilers only the portable kernels are built.
+#if defined(Q_PROCESSOR_X86_64) && defined(Q_CC_GNU)
+#define KREVERSI_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Bitboard
+{
+
+namespace
+{
+
+int scalarMobility(quint64 player, quint64 opponent)
+{
+    return popCount(scalarLegalMoves(player, opponent));
+}
+
+int scalarCountFlips(int square, quint64 player, quint64 opponent)
+{
+    return popCount(scalarFlips(square, player, opponent));
+}
+
+#ifdef KREVERSI_X86_KERNELS
+
+// The vector kernels follow runs of opponent chips in several directions
+// at once. Instead of masking the bits that wrap around the board edge
+// after every shift, they leave the chips on columns A and H out of the
+// runs going sideways: a run through them could not be closed anyway, and
+// a run that stays on the columns B to G never wraps. Runs are followed
+// two squares at a time after the first two, through pairs of opponent
+// chips, so a run of 6 chips takes four steps instead of six.
+const quint64 Inner = NotColumnA & NotColumnH;
+
+// SSE2, which every x86-64 CPU has. Its shifts move both halves of a
+// register by the same amount, so the first half holds the board and the
+// second half the board upside down: shifting the second half towards
+// the higher rows goes up on the real board. That covers the vertical and
+// diagonal directions, East and West are done the portable way.
+
+__m128i upsideDownPair(quint64 bits)
+{
+    return _mm_set_epi64x(qint64(flipVertical(bits)), qint64(bits));
+}
+
+quint64 foldPair(__m128i pair)
+{
+    return quint64(_mm_cvtsi128_si64(pair))
+           | flipVertical(quint64(_mm_cvtsi128_si64(_mm_unpackhi_epi64(pair, pair))));
+}
+
+template<int Step>
+__m128i sse2PairMoves(__m128i player, __m128i opponent)
+{
+    __m128i run = _mm_and_si128(_mm_slli_epi64(player, Step), opponent);
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, Step), opponent));
+    const __m128i pairs = _mm_and_si128(opponent, _mm_slli_epi64(opponent, Step));
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, 2 * Step), pairs));
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, 2 * Step), pairs));
+    return _mm_slli_epi64(run, Step);
+}
+
+quint64 sse2LegalMoves(quint64 player, quint64 opponent)
+{
+    const __m128i p = upsideDownPair(player);
+    const __m128i o = upsideDownPair(opponent);
+    const __m128i inner = _mm_and_si128(o, _mm_set1_epi64x(qint64(Inner)));
+    const __m128i moves = _mm_or_si128(sse2PairMoves<8>(p, o),
+                                       _mm_or_si128(sse2PairMoves<9>(p, inner), sse2PairMoves<7>(p, inner)));
+    return (foldPair(moves) | movesInDirection<East>(player, opponent)
+            | movesInDirection<West>(player, opponent)) & ~(player | opponent);
+}
+
+template<int Step>
+__m128i sse2PairFlips(__m128i move, __m128i player, __m128i opponent)
+{
+    __m128i run = _mm_and_si128(_mm_slli_epi64(move, Step), opponent);
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, Step), opponent));
+    const __m128i pairs = _mm_and_si128(opponent, _mm_slli_epi64(opponent, Step));
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, 2 * Step), pairs));
+    run = _mm_or_si128(run, _mm_and_si128(_mm_slli_epi64(run, 2 * Step), pairs));
+
+    // keep the runs closed by a chip of the player; SSE2 compares only
+    // 32 bits at a time, so both halves of a 64 bit lane must be 0
+    const __m128i closer = _mm_and_si128(_mm_slli_epi64(run, Step), player);
+    __m128i open = _mm_cmpeq_epi32(closer, _mm_setzero_si128());
+    open = _mm_and_si128(open, _mm_shuffle_epi32(open, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_andnot_si128(open, run);
+}
+
+quint64 sse2Flips(int square, quint64 player, quint64 opponent)
+{
+    const quint64 move = squareBit(square);
+    const __m128i m = upsideDownPair(move);
+    const __m128i p = upsideDownPair(player);
+    const __m128i o = upsideDownPair(opponent);
+    const __m128i inner = _mm_and_si128(o, _mm_set1_epi64x(qint64(Inner)));
+    const __m128i flips = _mm_or_si128(sse2PairFlips<8>(m, p, o),
+                                       _mm_or_si128(sse2PairFlips<9>(m, p, inner), sse2PairFlips<7>(m, p, inner)));
+    return foldPair(flips) | flipsInDirection<East>(move, player, opponent)
+           | flipsInDirection<West>(move, player, opponent);
+}
+
+int sse2Mobility(quint64 player, quint64 opponent)
+{
+    return popCount(sse2LegalMoves(player, opponent));
+}
+
+int sse2CountFlips(int square, quint64 player, quint64 opponent)
+{
+    return popCount(sse2Flips(square, player, opponent));
+}
+
+// The same with the POPCNT instruction, which came long before AVX2.
+
+__attribute__((target("popcnt")))
+int popcntMobility(quint64 player, quint64 opponent)
+{
+    return popCount(sse2LegalMoves(player, opponent));
+}
+
+__attribute__((target("popcnt")))
+int popcntCountFlips(int square, quint64 player, quint64 opponent)
+{
+    return popCount(sse2Flips(square, player, opponent));
+}
+
+// AVX2 shifts each of the four 64 bit lanes of a register by an amount of
+// its own, so one register goes in the four directions that shift towards
+// the higher squares (East, South, SouthEast and SouthWest) and another
+// one in the other four.
+
+__attribute__((target("avx2")))
+quint64 foldLanes(__m256i lanes)
+{
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+    half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+    return quint64(_mm_cvtsi128_si64(half));
+}
+
+__attribute__((target("avx2")))
+__m256i avx2Opponent(quint64 opponent)
+{
+    return _mm256_and_si256(_mm256_set1_epi64x(qint64(opponent)),
+                            _mm256_set_epi64x(qint64(Inner), qint64(Inner), -1, qint64(Inner)));
+}
+
+__attribute__((target("avx2,popcnt")))
+quint64 avx2LegalMoves(quint64 player, quint64 opponent)
+{
+    const __m256i step = _mm256_set_epi64x(7, 9, 8, 1);
+    const __m256i step2 = _mm256_add_epi64(step, step);
+    const __m256i p = _mm256_set1_epi64x(qint64(player));
+    const __m256i o = avx2Opponent(opponent);
+
+    __m256i up = _mm256_and_si256(_mm256_sllv_epi64(p, step), o);
+    __m256i down = _mm256_and_si256(_mm256_srlv_epi64(p, step), o);
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step), o));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step), o));
+    const __m256i upPairs = _mm256_and_si256(o, _mm256_sllv_epi64(o, step));
+    const __m256i downPairs = _mm256_and_si256(o, _mm256_srlv_epi64(o, step));
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step2), upPairs));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step2), downPairs));
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step2), upPairs));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step2), downPairs));
+
+    const __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(up, step), _mm256_srlv_epi64(down, step));
+    return foldLanes(moves) & ~(player | opponent);
+}
+
+__attribute__((target("avx2,popcnt")))
+quint64 avx2Flips(int square, quint64 player, quint64 opponent)
+{
+    const __m256i step = _mm256_set_epi64x(7, 9, 8, 1);
+    const __m256i step2 = _mm256_add_epi64(step, step);
+    const __m256i m = _mm256_set1_epi64x(qint64(squareBit(square)));
+    const __m256i p = _mm256_set1_epi64x(qint64(player));
+    const __m256i o = avx2Opponent(opponent);
+
+    __m256i up = _mm256_and_si256(_mm256_sllv_epi64(m, step), o);
+    __m256i down = _mm256_and_si256(_mm256_srlv_epi64(m, step), o);
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step), o));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step), o));
+    const __m256i upPairs = _mm256_and_si256(o, _mm256_sllv_epi64(o, step));
+    const __m256i downPairs = _mm256_and_si256(o, _mm256_srlv_epi64(o, step));
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step2), upPairs));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step2), downPairs));
+    up = _mm256_or_si256(up, _mm256_and_si256(_mm256_sllv_epi64(up, step2), upPairs));
+    down = _mm256_or_si256(down, _mm256_and_si256(_mm256_srlv_epi64(down, step2), downPairs));
+
+    // keep the runs closed by a chip of the player
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i upOpen = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_sllv_epi64(up, step), p), zero);
+    const __m256i downOpen = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srlv_epi64(down, step), p), zero);
+    return foldLanes(_mm256_or_si256(_mm256_andnot_si256(upOpen, up), _mm256_andnot_si256(downOpen, down)));
+}
+
+__attribute__((target("avx2,popcnt")))
+int avx2Mobility(quint64 player, quint64 opponent)
+{
+    return popCount(avx2LegalMoves(player, opponent));
+}
+
+__attribute__((target("avx2,popcnt")))
+int avx2CountFlips(int square, quint64 player, quint64 opponent)
+{
+    return popCount(avx2Flips(square, player, opponent));
+}
+
+#endif
+
+constexpr Kernels ScalarKernels = { "scalar", scalarLegalMoves, scalarMobility, scalarFlips, scalarCountFlips };
+
+void selectKernels()
+{
+    kernels = supportedKernels().first();
+}
+
+}
+
+// Until selectKernels() runs, anything that plays a move while the
+// program starts gets the portable kernels.
+Kernels kernels = ScalarKernels;
+
+Q_CONSTRUCTOR_FUNCTION(selectKernels)
+
+QVector<Kernels> supportedKernels()
+{
+    QVector<Kernels> supported;
+
+#ifdef KREVERSI_X86_KERNELS
+    // may run before the constructors of the runtime library
+    __builtin_cpu_init();
+    const bool popcnt = __builtin_cpu_supports("popcnt");
+    if (popcnt && __builtin_cpu_supports("avx2"))
+        supported.append({ "avx2", avx2LegalMoves, avx2Mobility, avx2Flips, avx2CountFlips });
+    if (popcnt)
+        supported.append({ "sse2-popcnt", sse2LegalMoves, popcntMobility, sse2Flips, popcntCountFlips });
+    supported.append({ "sse2", sse2LegalMoves, sse2Mobility, sse2Flips, sse2CountFlips });
+#endif
+
+    supported.append(ScalarKernels);
+    return supported;
+}
+}
@@ -0,0 +1,338 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_BITBOARD_H
+#define KREVERSI_BITBOARD_H
+
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ *  Helpers to work with a reversi board stored as two 64 bit masks,
+ *  one for the chips of the player to move and one for the opponent.
+ *
+ *  Square (row, col) is bit row * 8 + col, so bit 0 is A1 and bit 63 is H8.
+ *  Moving one column to the right is a shift by 1, one row down a shift
+ *  by 8. Bits that would wrap around the left or right edge are masked
+ *  away after shifting.
+ */
+namespace Bitboard
+{
+static const quint64 NotColumnA = 0xfefefefefefefefeULL;
+static const quint64 NotColumnH = 0x7f7f7f7f7f7f7f7fULL;
+
+/**
+ *  The eight directions chips can be turned in
+ */
+enum Direction {
+    East, West, South, North, SouthEast, SouthWest, NorthEast, NorthWest
+};
+
+inline int square(int row, int col)
+{
+    return row * 8 + col;
+}
+
+inline quint64 squareBit(int square)
+{
+    return quint64(1) << square;
+}
+
+inline int popCount(quint64 bits)
+{
+    return qPopulationCount(bits);
+}
+
+/**
+ *  @return index of the lowest set bit of @p bits, which must not be 0
+ */
+inline int firstSquare(quint64 bits)
+{
+    return qCountTrailingZeroBits(bits);
+}
+
+/**
+ *  The eight symmetries of the board
+ */
+enum Symmetry {
+    Identity, FlipVertical, MirrorHorizontal, Rotate180,
+    FlipDiagonal, FlipAntiDiagonal, Rotate90, Rotate270,
+    SymmetryCount
+};
+
+/**
+ *  @return @p bits with the rows in reverse order
+ */
+inline quint64 flipVertical(quint64 bits)
+{
+    return qbswap(bits);
+}
+
+/**
+ *  @return @p bits with the columns in reverse order
+ */
+inline quint64 mirrorHorizontal(quint64 bits)
+{
+    const quint64 k1 = 0x5555555555555555ULL;
+    const quint64 k2 = 0x3333333333333333ULL;
+    const quint64 k4 = 0x0f0f0f0f0f0f0f0fULL;
+    bits = ((bits >> 1) & k1) | ((bits & k1) << 1);
+    bits = ((bits >> 2) & k2) | ((bits & k2) << 2);
+    bits = ((bits >> 4) & k4) | ((bits & k4) << 4);
+    return bits;
+}
+
+/**
+ *  @return @p bits mirrored at the A1-H8 diagonal, so that (row, col)
+ *  becomes (col, row)
+ */
+inline quint64 flipDiagonal(quint64 bits)
+{
+    const quint64 k1 = 0x5500550055005500ULL;
+    const quint64 k2 = 0x3333000033330000ULL;
+    const quint64 k4 = 0x0f0f0f0f00000000ULL;
+    quint64 t = k4 & (bits ^ (bits << 28));
+    bits ^= t ^ (t >> 28);
+    t = k2 & (bits ^ (bits << 14));
+    bits ^= t ^ (t >> 14);
+    t = k1 & (bits ^ (bits << 7));
+    bits ^= t ^ (t >> 7);
+    return bits;
+}
+
+/**
+ *  @return @p bits mirrored at the A8-H1 diagonal, so that (row, col)
+ *  becomes (7 - col, 7 - row)
+ */
+inline quint64 flipAntiDiagonal(quint64 bits)
+{
+    const quint64 k1 = 0xaa00aa00aa00aa00ULL;
+    const quint64 k2 = 0xcccc0000cccc0000ULL;
+    const quint64 k4 = 0xf0f0f0f00f0f0f0fULL;
+    quint64 t = bits ^ (bits << 36);
+    bits ^= k4 & (t ^ (bits >> 36));
+    t = k2 & (bits ^ (bits << 18));
+    bits ^= t ^ (t >> 18);
+    t = k1 & (bits ^ (bits << 9));
+    bits ^= t ^ (t >> 9);
+    return bits;
+}
+
+/**
+ *  @return @p bits transformed by @p symmetry
+ */
+inline quint64 transform(quint64 bits, int symmetry)
+{
+    switch (symmetry) {
+    case FlipVertical:
+        return flipVertical(bits);
+    case MirrorHorizontal:
+        return mirrorHorizontal(bits);
+    case Rotate180:
+        return flipVertical(mirrorHorizontal(bits));
+    case FlipDiagonal:
+        return flipDiagonal(bits);
+    case FlipAntiDiagonal:
+        return flipAntiDiagonal(bits);
+    case Rotate90:
+        return flipVertical(flipDiagonal(bits));
+    case Rotate270:
+        return flipDiagonal(flipVertical(bits));
+    default:
+        return bits;
+    }
+}
+
+/**
+ *  @return the symmetry that undoes @p symmetry
+ */
+inline int inverse(int symmetry)
+{
+    if (symmetry == Rotate90)
+        return Rotate270;
+    if (symmetry == Rotate270)
+        return Rotate90;
+    return symmetry;
+}
+
+/**
+ *  Moves every chip of @p bits one square in direction @p Dir. Chips that
+ *  would leave the board are dropped.
+ */
+template<int Dir> inline quint64 shift(quint64 bits);
+
+template<> inline quint64 shift<East>(quint64 bits)
+{
+    return (bits << 1) & NotColumnA;
+}
+
+template<> inline quint64 shift<West>(quint64 bits)
+{
+    return (bits >> 1) & NotColumnH;
+}
+
+template<> inline quint64 shift<South>(quint64 bits)
+{
+    return bits << 8;
+}
+
+template<> inline quint64 shift<North>(quint64 bits)
+{
+    return bits >> 8;
+}
+
+template<> inline quint64 shift<SouthEast>(quint64 bits)
+{
+    return (bits << 9) & NotColumnA;
+}
+
+template<> inline quint64 shift<SouthWest>(quint64 bits)
+{
+    return (bits << 7) & NotColumnH;
+}
+
+template<> inline quint64 shift<NorthEast>(quint64 bits)
+{
+    return (bits >> 7) & NotColumnA;
+}
+
+template<> inline quint64 shift<NorthWest>(quint64 bits)
+{
+    return (bits >> 9) & NotColumnH;
+}
+
+/**
+ *  @return squares from which @p player closes a run of @p opponent chips
+ *  in direction @p Dir. A run is at most 6 chips long.
+ */
+template<int Dir>
+inline quint64 movesInDirection(quint64 player, quint64 opponent)
+{
+    quint64 run = shift<Dir>(player) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    return shift<Dir>(run);
+}
+
+/**
+ *  @return mask of all legal moves of @p player, the portable way
+ */
+inline quint64 scalarLegalMoves(quint64 player, quint64 opponent)
+{
+    const quint64 moves = movesInDirection<East>(player, opponent)
+                          | movesInDirection<West>(player, opponent)
+                          | movesInDirection<South>(player, opponent)
+                          | movesInDirection<North>(player, opponent)
+                          | movesInDirection<SouthEast>(player, opponent)
+                          | movesInDirection<SouthWest>(player, opponent)
+                          | movesInDirection<NorthEast>(player, opponent)
+                          | movesInDirection<NorthWest>(player, opponent);
+    return moves & ~(player | opponent);
+}
+
+/**
+ *  @return chips turned in direction @p Dir when @p player puts a chip
+ *  on @p move (a single bit)
+ */
+template<int Dir>
+inline quint64 flipsInDirection(quint64 move, quint64 player, quint64 opponent)
+{
+    quint64 run = shift<Dir>(move) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    run |= shift<Dir>(run) & opponent;
+    return (shift<Dir>(run) & player) ? run : 0;
+}
+
+/**
+ *  @return mask of all chips turned when @p player plays on @p square,
+ *  the portable way
+ */
+inline quint64 scalarFlips(int square, quint64 player, quint64 opponent)
+{
+    const quint64 move = squareBit(square);
+    return flipsInDirection<East>(move, player, opponent)
+           | flipsInDirection<West>(move, player, opponent)
+           | flipsInDirection<South>(move, player, opponent)
+           | flipsInDirection<North>(move, player, opponent)
+           | flipsInDirection<SouthEast>(move, player, opponent)
+           | flipsInDirection<SouthWest>(move, player, opponent)
+           | flipsInDirection<NorthEast>(move, player, opponent)
+           | flipsInDirection<NorthWest>(move, player, opponent);
+}
+
+/**
+ *  One implementation of the move generator. Besides the portable one
+ *  there are some using the vector instructions of x86 CPUs, see
+ *  supportedKernels().
+ */
+struct Kernels {
+    /**
+     *  Name of the kernels, as in "avx2" or "scalar"
+     */
+    const char *name;
+    quint64 (*legalMoves)(quint64 player, quint64 opponent);
+    int (*mobility)(quint64 player, quint64 opponent);
+    quint64 (*flips)(int square, quint64 player, quint64 opponent);
+    int (*countFlips)(int square, quint64 player, quint64 opponent);
+};
+
+/**
+ *  The kernels legalMoves(), mobility(), flips() and countFlips() call.
+ *  When the program starts, these are set to the first of
+ *  supportedKernels(). They may only be changed again while no other
+ *  thread uses them.
+ */
+extern Kernels kernels;
+
+/**
+ *  @return the kernels this CPU can run, the fastest first. The last
+ *  ones are the portable "scalar" kernels, which run everywhere.
+ */
+QVector<Kernels> supportedKernels();
+
+/**
+ *  @return mask of all legal moves of @p player
+ */
+inline quint64 legalMoves(quint64 player, quint64 opponent)
+{
+    return kernels.legalMoves(player, opponent);
+}
+
+/**
+ *  @return number of legal moves of @p player
+ */
+inline int mobility(quint64 player, quint64 opponent)
+{
+    return kernels.mobility(player, opponent);
+}
+
+/**
+ *  @return mask of all chips turned when @p player plays on @p square.
+ *  An empty mask means the move is illegal.
+ */
+inline quint64 flips(int square, quint64 player, quint64 opponent)
+{
+    return kernels.flips(square, player, opponent);
+}
+
+/**
+ *  @return number of chips turned when @p player plays on @p square
+ */
+inline int countFlips(int square, quint64 player, quint64 opponent)
+{
+    return kernels.countFlips(square, player, opponent);
+}
+}
+
+#endif
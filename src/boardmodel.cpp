@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "boardmodel.h"
+
+KReversiBoardModel::Cell::Cell()
+    : color(NoColor), isLegal(false), isHint(false), isLastMove(false), preAnimationTime(0)
+{
+}
+
+bool KReversiBoardModel::Cell::operator==(const Cell &other) const
+{
+    return color == other.color && isLegal == other.isLegal && isHint == other.isHint
+           && isLastMove == other.isLastMove && preAnimationTime == other.preAnimationTime;
+}
+
+KReversiBoardModel::KReversiBoardModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int KReversiBoardModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : CELL_COUNT;
+}
+
+QVariant KReversiBoardModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= CELL_COUNT)
+        return QVariant();
+
+    const Cell &cell = m_cells[index.row()];
+    switch (role) {
+    case ChipStateRole:
+        switch (cell.color) {
+        case Black:
+            return QStringLiteral("Black");
+        case White:
+            return QStringLiteral("White");
+        case NoColor:
+            break;
+        }
+        return QString();
+    case IsLegalRole:
+        return cell.isLegal;
+    case IsHintRole:
+        return cell.isHint;
+    case IsLastMoveRole:
+        return cell.isLastMove;
+    case PreAnimationTimeRole:
+        return cell.preAnimationTime;
+    }
+
+    return QVariant();
+}
+
+QHash<int, QByteArray> KReversiBoardModel::roleNames() const
+{
+    QHash<int, QByteArray> names;
+    names[ChipStateRole] = "chipState";
+    names[IsLegalRole] = "isLegal";
+    names[IsHintRole] = "isHint";
+    names[IsLastMoveRole] = "isLastMove";
+    names[PreAnimationTimeRole] = "preAnimationTime";
+    return names;
+}
+
+void KReversiBoardModel::setCells(const Cell *cells)
+{
+    // Delays are sent in a batch of their own before anything else, so that
+    // a chip already knows how long to wait when its color changes
+    int first = CELL_COUNT;
+    int last = -1;
+    for (int i = 0; i < CELL_COUNT; i++) {
+        if (m_cells[i].preAnimationTime != cells[i].preAnimationTime) {
+            m_cells[i].preAnimationTime = cells[i].preAnimationTime;
+            first = qMin(first, i);
+            last = i;
+        }
+    }
+    if (last >= 0)
+        Q_EMIT dataChanged(index(first), index(last), {PreAnimationTimeRole});
+
+    // The rest goes in a single batch spanning the changed cells, naming
+    // only the roles that changed in any of them
+    bool color = false, legal = false, hint = false, lastMove = false;
+    first = CELL_COUNT;
+    last = -1;
+    for (int i = 0; i < CELL_COUNT; i++) {
+        if (m_cells[i] == cells[i])
+            continue;
+
+        color = color || m_cells[i].color != cells[i].color;
+        legal = legal || m_cells[i].isLegal != cells[i].isLegal;
+        hint = hint || m_cells[i].isHint != cells[i].isHint;
+        lastMove = lastMove || m_cells[i].isLastMove != cells[i].isLastMove;
+        m_cells[i] = cells[i];
+        first = qMin(first, i);
+        last = i;
+    }
+    if (last < 0)
+        return;
+
+    QVector<int> roles;
+    if (color)
+        roles.append(ChipStateRole);
+    if (legal)
+        roles.append(IsLegalRole);
+    if (hint)
+        roles.append(IsHintRole);
+    if (lastMove)
+        roles.append(IsLastMoveRole);
+    Q_EMIT dataChanged(index(first), index(last), roles);
+}
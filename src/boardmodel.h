@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_BOARDMODEL_H
+#define KREVERSI_BOARDMODEL_H
+
+#include <QAbstractListModel>
+
+#include "commondefs.h"
+
+/**
+ *  The 64 cells of the board as shown by Board.qml, one row each, row
+ *  number being @c row * 8 + @c column.
+ *
+ *  KReversiView hands over the whole board on every change. Only the cells
+ *  which really differ from the shown ones are reported to QML, in as few
+ *  dataChanged() notifications as possible.
+ */
+class KReversiBoardModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    /**
+     *  What QML shows on a single cell
+     */
+    struct Cell {
+        Cell();
+        bool operator==(const Cell &other) const;
+
+        /**
+         *  Color of the chip, @c NoColor for an empty cell
+         */
+        ChipColor color;
+        bool isLegal;
+        bool isHint;
+        bool isLastMove;
+        /**
+         *  How long the chip waits before it starts turning, in milliseconds
+         */
+        int preAnimationTime;
+    };
+
+    enum Roles {
+        ChipStateRole = Qt::UserRole + 1,
+        IsLegalRole,
+        IsHintRole,
+        IsLastMoveRole,
+        PreAnimationTimeRole
+    };
+
+    static const int CELL_COUNT = 64;
+
+    explicit KReversiBoardModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     *  Shows @p cells, an array of CELL_COUNT cells
+     */
+    void setCells(const Cell *cells);
+
+private:
+    Cell m_cells[CELL_COUNT];
+};
+
+#endif
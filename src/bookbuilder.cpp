@@ -0,0 +1,164 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// kreversi-book: builds the opening book used by the engine from a list
+// of game transcripts.
+//
+// The transcripts hold one game per line (see transcript.h).
+//
+// For every position of the first --depth moves the book keeps the move
+// with the best average result for the player to move, provided it was
+// played in at least --min-games games.
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+
+#include "bitboard.h"
+#include "openingbook.h"
+#include "transcript.h"
+
+namespace
+{
+
+struct MoveStats {
+    quint32 games = 0;
+    qint64  score = 0;
+};
+
+// All moves played in one (canonical) position, by canonical square
+typedef QHash<int, MoveStats> PositionStats;
+
+// Adds the first depth moves of game to stats.
+void addGame(const Transcript::Game &game, int depth, QHash<quint64, PositionStats> &stats)
+{
+    quint64 player = Bitboard::squareBit(Bitboard::square(3, 4)) | Bitboard::squareBit(Bitboard::square(4, 3));
+    quint64 opponent = Bitboard::squareBit(Bitboard::square(3, 3)) | Bitboard::squareBit(Bitboard::square(4, 4));
+    int result = game.result; // for the player to move
+
+    for (int i = 0; i < game.moves.size() && i < depth; ++i) {
+        if (!Bitboard::legalMoves(player, opponent)) {
+            qSwap(player, opponent);
+            result = -result;
+        }
+
+        // Symmetric positions have several canonical moves for the same
+        // real one, take the lowest.
+        quint64 canonicalPlayer = player;
+        quint64 canonicalOpponent = opponent;
+        const int symmetries = OpeningBook::canonicalize(canonicalPlayer, canonicalOpponent);
+        int move = 64;
+        for (int s = 0; s < Bitboard::SymmetryCount; ++s) {
+            if (symmetries & (1 << s))
+                move = qMin(move, Bitboard::firstSquare(Bitboard::transform(Bitboard::squareBit(game.moves[i]), s)));
+        }
+
+        MoveStats &moveStats = stats[OpeningBook::key(canonicalPlayer, canonicalOpponent)][move];
+        moveStats.games++;
+        moveStats.score += result;
+
+        const quint64 flips = Bitboard::flips(game.moves[i], player, opponent);
+        player ^= flips | Bitboard::squareBit(game.moves[i]);
+        opponent ^= flips;
+        qSwap(player, opponent);
+        result = -result;
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kreversi-book"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Builds the KReversi opening book from game transcripts."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("transcripts"), QStringLiteral("Files with one game per line."),
+                                 QStringLiteral("transcripts..."));
+    const QCommandLineOption outputOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"),
+                                          QStringLiteral("Write the book to <file>."),
+                                          QStringLiteral("file"), QStringLiteral("book.bin"));
+    const QCommandLineOption depthOption(QStringLiteral("depth"),
+                                         QStringLiteral("Use the first <moves> moves of each game."),
+                                         QStringLiteral("moves"), QStringLiteral("20"));
+    const QCommandLineOption minGamesOption(QStringLiteral("min-games"),
+                                            QStringLiteral("Only keep moves played in at least <count> games."),
+                                            QStringLiteral("count"), QStringLiteral("2"));
+    parser.addOption(outputOption);
+    parser.addOption(depthOption);
+    parser.addOption(minGamesOption);
+    parser.process(application);
+
+    const QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty())
+        parser.showHelp(1);
+
+    const int depth = parser.value(depthOption).toInt();
+    const quint32 minGames = parser.value(minGamesOption).toUInt();
+
+    QTextStream err(stderr);
+    QHash<quint64, PositionStats> stats;
+    int games = 0;
+
+    for (const QString &input : inputs) {
+        QFile file(input);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            err << input << ": " << file.errorString() << '\n';
+            return 1;
+        }
+
+        QTextStream in(&file);
+        for (int lineNumber = 1; !in.atEnd(); ++lineNumber) {
+            const QString line = in.readLine();
+            if (line.trimmed().isEmpty() || line.startsWith(QLatin1Char('#')))
+                continue;
+
+            Transcript::Game game;
+            QString error;
+            if (!Transcript::parse(line, game, error)) {
+                err << input << ':' << lineNumber << ": " << error << ", skipped\n";
+                continue;
+            }
+            addGame(game, depth, stats);
+            games++;
+        }
+    }
+
+    QVector<OpeningBook::Entry> entries;
+    for (auto position = stats.constBegin(); position != stats.constEnd(); ++position) {
+        OpeningBook::Entry best = { position.key(), 0, 0, 0, 0 };
+        double bestScore = 0;
+
+        for (auto move = position->constBegin(); move != position->constEnd(); ++move) {
+            if (move->games < minGames)
+                continue;
+            const double score = double(move->score) / move->games;
+            if (best.games == 0 || score > bestScore
+                    || (score == bestScore && move->games > best.games)) {
+                best.games = move->games;
+                best.score = qint16(qRound(score));
+                best.move = quint8(move.key());
+                bestScore = score;
+            }
+        }
+
+        if (best.games > 0)
+            entries.append(best);
+    }
+
+    if (!OpeningBook::save(parser.value(outputOption), entries)) {
+        err << parser.value(outputOption) << ": cannot write the book\n";
+        return 1;
+    }
+
+    err << games << " games, " << entries.size() << " positions\n";
+    return 0;
+}
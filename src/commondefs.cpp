@@ -16,15 +16,6 @@ QString Utils::chipPrefixToString(ChipsPrefix prefix) {
     return chipPrefixString[prefix];
 }
 
-ChipColor Utils::opponentColorFor(ChipColor color)
-{
-    if (color == NoColor)
-        return NoColor;
-    else
-        return (color == White ? Black : White);
-}
-
-
 QString Utils::colorToString(ChipColor color)
 {
     if (Preferences::useColoredChips())
@@ -11,60 +11,9 @@
 #include <QString>
 #include <KgDifficulty>
 
+#include "kreversimove.h"
 #include "preferences.h"
 
-/**
- * Used to indicate chip's state.
- */
-enum ChipColor {
-    /** White state */
-    White = 0,
-    /** Black state */
-    Black = 1,
-    /** No chip (empty cell) */
-    NoColor = 2
-};
-
-static const int nRows = 8;
-static const int nCols = 8;
-
-/**
- * Represents position on board.
- */
-struct KReversiPos {
-    KReversiPos(int r = -1, int c = -1)
-        : row(r), col(c) { }
-
-    int row;
-    int col;
-
-    bool isValid() const {
-        return (row >= 0 && col >= 0 && row < nRows && col < nCols);
-    }
-};
-
-/**
- * Represents move of player.
- * It is KReversiPos + ChipColor
- */
-struct KReversiMove: public KReversiPos {
-    KReversiMove(ChipColor col = NoColor, int r = -1, int c = -1)
-        : KReversiPos(r, c), color(col) { }
-
-    KReversiMove(ChipColor col, KReversiPos pos)
-        : KReversiPos(pos), color(col) { }
-
-    ChipColor color;
-
-    bool isValid() const {
-        return (color != NoColor
-                && row >= 0 && col >= 0
-                && row < nRows && col < nCols);
-    }
-};
-
-typedef QList<KReversiMove> MoveList;
-
 /**
  * Indicates current color setting of user
  */
@@ -83,13 +32,6 @@ namespace Utils
  *         @c "chip_color" for @c Colored
  */
 QString chipPrefixToString(ChipsPrefix prefix);
-/**
- * Return opposite color for @p color
- * @return @c Black for @c White
- *         @c White for @c Black
- *         @c NoColor for @c NoColor
- */
-ChipColor opponentColorFor(ChipColor color);
 /**
  * @return Human-readable string representing @p color
  */
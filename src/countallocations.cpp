@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Counts the allocations of every thread for NoAllocations, in the
+// programs that are built with this file; the engine library and the
+// game are not.
+//
+// With glibc a program can replace malloc() for itself and every library
+// it loads, so the functions below catch operator new as well as Qt's
+// containers and anything else that allocates. They count and then call
+// the allocator of glibc, so free() is left alone. With other C
+// libraries, and in builds without assertions, nothing is counted.
+
+#include "allocationcounter.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#if !defined(QT_NO_DEBUG) && defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+
+thread_local quint64 allocations = 0;
+
+quint64 countAllocations()
+{
+    return allocations;
+}
+
+void startCounting()
+{
+    NoAllocations::counter = countAllocations;
+}
+
+}
+
+Q_CONSTRUCTOR_FUNCTION(startCounting)
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    allocations++;
+    return __libc_realloc(p, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) || (alignment & (alignment - 1)))
+        return EINVAL;
+    allocations++;
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory)
+        return ENOMEM;
+    *p = memory;
+    return 0;
+}
+
+}
+
+#endif
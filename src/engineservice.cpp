@@ -0,0 +1,51 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "engineservice.h"
+
+#include <QStandardPaths>
+#include <QWeakPointer>
+
+#include "preferences.h"
+
+QSharedPointer<EngineService> EngineService::instance()
+{
+    // the service goes away with the last handle, and its table with the
+    // last engine using it
+    static QWeakPointer<EngineService> service;
+
+    QSharedPointer<EngineService> handle = service.toStrongRef();
+    if (!handle) {
+        handle = QSharedPointer<EngineService>(new EngineService);
+        service = handle;
+    }
+    return handle;
+}
+
+EngineService::EngineService()
+    : m_tableSize(0)
+{
+}
+
+Engine *EngineService::createEngine(int strength)
+{
+    // Engines that are searching may not have their table resized, so a
+    // new size gets a new table. The engines still using the old one keep
+    // it until they are deleted.
+    const int megabytes = Preferences::hashTableSize();
+    if (!m_table || m_tableSize != megabytes) {
+        m_table.reset(new TranspositionTable);
+        m_table->resize(megabytes);
+        m_tableSize = megabytes;
+    }
+
+    Engine *engine = new Engine(strength);
+    engine->setTable(m_table);
+    engine->setThreads(Preferences::threads());
+    engine->setOpeningBook(QStandardPaths::locate(QStandardPaths::AppDataLocation,
+                                                  QStringLiteral("book.bin")));
+    return engine;
+}
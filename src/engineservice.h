@@ -0,0 +1,55 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_ENGINESERVICE_H
+#define KREVERSI_ENGINESERVICE_H
+
+#include <QSharedPointer>
+
+#include "Engine.h"
+
+/**
+ *  What the engines of the game share: there is one service per process,
+ *  kept alive by the handles the game and the computer players hold.
+ *
+ *  The engines it makes are set up from the preferences and all use the
+ *  same transposition table. So a game with a computer player needs the
+ *  memory for one table instead of one for each engine, and what the
+ *  computer player found out while thinking or pondering is known to the
+ *  hint engine and the other way round.
+ *
+ *  Only to be used from the GUI thread.
+ */
+class EngineService
+{
+public:
+    /**
+     *  @return the service of this process, made if there is none yet
+     */
+    static QSharedPointer<EngineService> instance();
+
+    /**
+     *  @return a new engine of @p strength, with the number of threads,
+     *  the table size and the opening book of the preferences. The caller
+     *  takes ownership of it and must delete it while still holding its
+     *  handle to the service.
+     */
+    Engine *createEngine(int strength);
+
+private:
+    EngineService();
+
+    /**
+     *  The table of the engines made since the table size last changed
+     */
+    QSharedPointer<TranspositionTable> m_table;
+    /**
+     *  Size of m_table in megabytes
+     */
+    int m_tableSize;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "historymodel.h"
+
+#include "commondefs.h"
+#include "kreversigame.h"
+
+KReversiHistoryModel::KReversiHistoryModel(QObject *parent)
+    : QAbstractListModel(parent), m_game(nullptr), m_size(0)
+{
+}
+
+void KReversiHistoryModel::setGame(KReversiGame *game)
+{
+    beginResetModel();
+
+    if (m_game)
+        disconnect(m_game, nullptr, this, nullptr);
+
+    m_game = game;
+    m_size = m_game ? m_game->historySize() : 0;
+
+    if (m_game) {
+        connect(m_game, &KReversiGame::historyAppended, this, &KReversiHistoryModel::appendMove);
+        connect(m_game, &KReversiGame::historyTruncated, this, &KReversiHistoryModel::truncate);
+    }
+
+    endResetModel();
+}
+
+int KReversiHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_size;
+}
+
+QVariant KReversiHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!m_game || !index.isValid() || index.row() >= m_size || role != Qt::DisplayRole)
+        return QVariant();
+
+    QString numStr = QString::number(index.row() + 1) + QStringLiteral(". ");
+    return numStr + Utils::moveToString(m_game->historyMove(index.row()));
+}
+
+void KReversiHistoryModel::appendMove(int ply)
+{
+    if (ply < m_size)
+        return;
+
+    beginInsertRows(QModelIndex(), m_size, ply);
+    m_size = ply + 1;
+    endInsertRows();
+}
+
+void KReversiHistoryModel::truncate(int size)
+{
+    if (size >= m_size)
+        return;
+
+    beginRemoveRows(QModelIndex(), size, m_size - 1);
+    m_size = size;
+    endRemoveRows();
+}
@@ -0,0 +1,54 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_HISTORYMODEL_H
+#define KREVERSI_HISTORYMODEL_H
+
+#include <QAbstractListModel>
+
+class KReversiGame;
+
+/**
+ *  The moves of a KReversiGame, one row each, as shown in the move history
+ *  dock.
+ *
+ *  Rows are added and removed when the game reports a move or an undo, so
+ *  a move costs the same however long the game already is. The text of a
+ *  row is only made when a view asks for it.
+ */
+class KReversiHistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit KReversiHistoryModel(QObject *parent = nullptr);
+
+    /**
+     *  Shows the moves of @p game from now on. @p game may be @c nullptr
+     *  for none
+     */
+    void setGame(KReversiGame *game);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    /**
+     *  Adds the rows up to move number @p ply
+     */
+    void appendMove(int ply);
+    /**
+     *  Removes the rows from @p size on
+     */
+    void truncate(int size);
+
+    KReversiGame *m_game;
+    /**
+     *  Number of rows, as last reported by the game
+     */
+    int m_size;
+};
+
+#endif
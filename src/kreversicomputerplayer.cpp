@@ -7,13 +7,18 @@
 #include "kreversicomputerplayer.h"
 
 KReversiComputerPlayer::KReversiComputerPlayer(ChipColor color, const QString &name):
-    KReversiPlayer(color, name, false, false), m_lowestSkill(100) // setting it big enough
+    KReversiPlayer(color, name, false, false), m_lowestSkill(100), // setting it big enough
+    m_pondering(false), m_ponderAllowed(true)
 {
-    m_engine = new Engine(1);
+    m_engineService = EngineService::instance();
+    m_engine = m_engineService->createEngine(1);
+
+    connect(&m_watcher, &QFutureWatcher<KReversiMove>::finished, this, &KReversiComputerPlayer::moveComputed);
 }
 
 KReversiComputerPlayer::~KReversiComputerPlayer()
 {
+    m_watcher.cancel();
     delete m_engine;
 }
 
@@ -21,6 +26,7 @@ void KReversiComputerPlayer::prepare(KReversiGame *game)
 {
     m_game = game;
     m_state = WAITING;
+    connect(m_game, &KReversiGame::boardChanged, this, &KReversiComputerPlayer::boardChanged);
 
     Q_EMIT ready();
 }
@@ -28,10 +34,73 @@ void KReversiComputerPlayer::prepare(KReversiGame *game)
 void KReversiComputerPlayer::takeTurn()
 {
     m_state = THINKING;
-    KReversiMove move = m_engine->computeMove(*m_game, true);
+    m_position = m_game->position();
+
+    // A ponder hit: the engine has been searching this position for a
+    // while already.  It may even be done.
+    if (m_pondering && m_engine->ponderPosition() == m_position) {
+        m_pondering = false;
+        m_engine->ponderHit();
+        if (m_watcher.isFinished())
+            moveComputed();
+        return;
+    }
+
+    stopPondering();
+    m_watcher.setFuture(m_engine->startComputeMove(m_position, true));
+}
+
+void KReversiComputerPlayer::moveComputed()
+{
+    if (m_state != THINKING || m_watcher.isCanceled())
+        return;
+
+    KReversiMove move = m_watcher.result();
     move.color = m_color;
     m_state = WAITING;
     Q_EMIT makeMove(move);
+
+    // The game may have taken the turn straight back from us, for
+    // instance because the move was refused.
+    if (m_state == WAITING && move.isValid()) {
+        Position position = m_position;
+        position.play(Bitboard::square(move.row, move.col));
+        startPondering(position);
+    }
+}
+
+void KReversiComputerPlayer::startPondering(const Position &position)
+{
+    // Nothing to ponder on if the opponent cannot move.
+    if (!m_ponderAllowed || !Preferences::ponder() || !Bitboard::legalMoves(position.player(), position.opponent()))
+        return;
+
+    m_ponderFrom = position;
+    m_pondering = true;
+    m_watcher.setFuture(m_engine->startPonder(position, true));
+}
+
+void KReversiComputerPlayer::stopPondering()
+{
+    if (!m_pondering)
+        return;
+
+    m_pondering = false;
+    m_engine->setInterrupt(true);
+    m_watcher.cancel();
+}
+
+void KReversiComputerPlayer::boardChanged()
+{
+    if (!m_pondering)
+        return;
+
+    // While the chips turn nobody is to move, so only the chips count.
+    const Position board = m_game->position();
+    const Position ponder = m_engine->ponderPosition();
+    if ((board.black != m_ponderFrom.black || board.white != m_ponderFrom.white)
+            && (board.black != ponder.black || board.white != ponder.white))
+        stopPondering();
 }
 
 void KReversiComputerPlayer::skipTurn()
@@ -41,6 +110,9 @@ void KReversiComputerPlayer::skipTurn()
 
 void KReversiComputerPlayer::gameOver()
 {
+    stopPondering();
+    m_engine->setInterrupt(true);
+    m_watcher.cancel();
     m_state = UNKNOWN;
 }
 
@@ -55,4 +127,11 @@ int KReversiComputerPlayer::lowestSkill()
     return m_lowestSkill;
 }
 
+void KReversiComputerPlayer::setPonderAllowed(bool allowed)
+{
+    m_ponderAllowed = allowed;
+    if (!allowed)
+        stopPondering();
+}
+
 
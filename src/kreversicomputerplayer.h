@@ -7,6 +7,9 @@
 #ifndef KREVERSICOMPUTERPLAYER_H
 #define KREVERSICOMPUTERPLAYER_H
 
+#include <QFutureWatcher>
+
+#include "engineservice.h"
 #include "kreversiplayer.h"
 
 /**
@@ -43,13 +46,55 @@ public:
      */
     int lowestSkill();
 
+    /**
+     *  Sets whether the engine may think on the opponent's time, if the
+     *  settings allow it. Two computer players should not both ponder:
+     *  their engines would share the same cores and slow each other down.
+     */
+    void setPonderAllowed(bool allowed);
+
 Q_SIGNALS:
 
 public Q_SLOTS:
 
+private Q_SLOTS:
+    /**
+     *  Makes the move found by the engine, unless the turn has been
+     *  taken away from us in the meantime
+     */
+    void moveComputed();
+
+    /**
+     *  Stops pondering when the board is no longer on its way to the
+     *  position pondered on, e.g. after an undo
+     */
+    void boardChanged();
+
 private:
+    /**
+     *  Lets the engine think on the opponent's time, starting from
+     *  @p position after our move
+     */
+    void startPondering(const Position &position);
+    void stopPondering();
+
     int m_lowestSkill;
+    /**
+     *  Handle to the service m_engine comes from
+     */
+    QSharedPointer<EngineService> m_engineService;
     Engine *m_engine;
+    QFutureWatcher<KReversiMove> m_watcher;
+    /**
+     *  The position searched by takeTurn()
+     */
+    Position m_position;
+    /**
+     *  The position after our move while the engine is pondering
+     */
+    Position m_ponderFrom;
+    bool m_pondering;
+    bool m_ponderAllowed;
 };
 
 #endif // KREVERSICOMPUTERPLAYER_H
@@ -8,23 +8,27 @@
 #include "kreversigame.h"
 
 
+// Hints are searched for as deep as the strongest computer player would,
+// getting better with every level, but for no longer than HINT_TIME
+// milliseconds.
+static const int HINT_STRENGTH = 6;
+static const int HINT_TIME = 5000;
+
 const int KReversiGame::DX[KReversiGame::DIRECTIONS_COUNT] = {0, 0, 1, 1, 1, -1, -1, -1};
 const int KReversiGame::DY[KReversiGame::DIRECTIONS_COUNT] = {1, -1, 1, 0, -1, 1, 0, -1};
 
 KReversiGame::KReversiGame(KReversiPlayer *blackPlayer, KReversiPlayer *whitePlayer)
-    : m_delay(300), m_curPlayer(Black)
+    : m_delay(300), m_engine(nullptr), m_curPlayer(Black), m_plies(0)
 {
     m_isReady[White] = m_isReady[Black] = false;
 
-    // reset board
-    for (int r = 0; r < 8; ++r)
-        for (int c = 0; c < 8; ++c)
-            m_cells[r][c] = NoColor;
-    // initial pos
-    m_cells[3][3] = m_cells[4][4] = White;
-    m_cells[3][4] = m_cells[4][3] = Black;
+    memset(m_turnOrder, 0, sizeof(m_turnOrder));
 
-    m_score[White] = m_score[Black] = 2;
+    // initial pos
+    const Position start = Position::start();
+    m_chips[White] = start.white;
+    m_chips[Black] = start.black;
+    updateLegalMoves();
 
     m_player[White] = whitePlayer;
     m_player[Black] = blackPlayer;
@@ -41,7 +45,7 @@ KReversiGame::KReversiGame(KReversiPlayer *blackPlayer, KReversiPlayer *whitePla
     connect(whitePlayer, &KReversiPlayer::makeMove, this, &KReversiGame::whitePlayerMove);
     connect(whitePlayer, &KReversiPlayer::ready, this, &KReversiGame::whiteReady);
 
-    m_engine = new Engine(1);
+    connect(&m_hintWatcher, &QFutureWatcher<KReversiMove>::finished, this, &KReversiGame::hintComputed);
 
     whitePlayer->prepare(this);
     blackPlayer->prepare(this);
@@ -49,6 +53,7 @@ KReversiGame::KReversiGame(KReversiPlayer *blackPlayer, KReversiPlayer *whitePla
 
 KReversiGame::~KReversiGame()
 {
+    m_hintWatcher.cancel();
     delete m_engine;
 }
 
@@ -56,7 +61,7 @@ bool KReversiGame::canUndo() const
 {
     if (m_curPlayer == NoColor)
         return false;
-    return (m_player[m_curPlayer]->isUndoAllowed() && !m_undoStack.isEmpty());
+    return (m_player[m_curPlayer]->isUndoAllowed() && m_plies > 0);
 }
 
 void KReversiGame::makeMove(KReversiMove move)
@@ -74,11 +79,15 @@ void KReversiGame::makeMove(KReversiMove move)
         return; // Unpossible move
     }
 
+    // a hint still being searched for is about the old board
+    cancelHint();
+
     m_lastPlayer = m_curPlayer;
     m_curPlayer = NoColor; // both players wait for animations
 
     turnChips(move);
-    
+    Q_EMIT historyAppended(m_plies - 1);
+
     m_delayTimer.singleShot(m_delay * (qMax(1, m_changedChips.count() - 1)), this, &KReversiGame::onDelayTimer);
     Q_EMIT boardChanged();
 }
@@ -112,46 +121,24 @@ void KReversiGame::startNextTurn()
 int KReversiGame::undo()
 {
     m_player[m_curPlayer]->undoUsed();
+    cancelHint();
     // we're undoing all moves (if any) until we meet move done by a player.
     // We undo that player move too and we're done.
     // Simply put: we're undoing all_moves_of_computer + one_move_of_player
 
     int movesUndone = 0;
 
-    while (!m_undoStack.isEmpty()) {
-        MoveList lastUndo = m_undoStack.pop();
-        // One thing that matters here is that we take the
-        // chip color directly from board, rather than from move.color
-        // That allows to take into account a previously made undo, while
-        // undoing changes which are in the current list
-        // Sounds not very understandable?
-        // Then try to use move.color instead of m_cells[row][col]
-        // and it will mess things when undoing such moves as
-        // "Player captures computer-owned chip,
-        //  Computer makes move and captures this chip back"
-        //  Yes, I like long descriptions in comments ;).
-
-        KReversiMove move = lastUndo.takeFirst();
-        setChipColor(KReversiMove(NoColor, move.row, move.col));
-
-        // and change back the color of the rest chips
-        for (const KReversiMove & pos : qAsConst(lastUndo)) {
-            ChipColor opponentColor = Utils::opponentColorFor(m_cells[pos.row][pos.col]);
-            setChipColor(KReversiMove(opponentColor, pos.row, pos.col));
-        }
-
-        lastUndo.clear();
+    while (m_plies > 0) {
+        const KReversiMove move = takeBackPly();
 
         movesUndone++;
         if (move.color == m_curPlayer)
             break; //we've undone all opponent's + one current player's moves
     }
 
-    if (!m_undoStack.empty())
-        m_changedChips = m_undoStack.top();
-    else
-        m_changedChips.clear();
+    setChangedChips(m_plies > 0 ? chipsChangedBy(m_undoLog[m_plies - 1]) : MoveList());
 
+    Q_EMIT historyTruncated(m_plies);
     Q_EMIT boardChanged();
     kickCurrentPlayer();
 
@@ -160,95 +147,89 @@ int KReversiGame::undo()
 
 void KReversiGame::turnChips(KReversiMove move)
 {
-    m_changedChips.clear();
+    Q_ASSERT(m_plies < MAX_PLIES);
+
+    const int square = Bitboard::square(move.row, move.col);
+    const ChipColor opponent = Utils::opponentColorFor(move.color);
+    const quint64 flips = Bitboard::flips(square, m_chips[move.color], m_chips[opponent]);
+
+    m_chips[move.color] ^= flips | Bitboard::squareBit(square);
+    m_chips[opponent] ^= flips;
+    updateLegalMoves();
+
+    Ply &ply = m_undoLog[m_plies++];
+    ply.flips = flips;
+    ply.square = qint8(square);
+    ply.color = qint8(move.color);
+
+    setChangedChips(chipsChangedBy(ply));
+}
+
+void KReversiGame::setChangedChips(const MoveList &chips)
+{
+    m_changedChips = chips;
+
+    memset(m_turnOrder, 0, sizeof(m_turnOrder));
+    for (int i = 1; i < chips.size(); i++)
+        m_turnOrder[Bitboard::square(chips[i].row, chips[i].col)] = qint8(i - 1);
+}
+
+KReversiMove KReversiGame::takeBackPly()
+{
+    const Ply &ply = m_undoLog[--m_plies];
+    const ChipColor color = ChipColor(ply.color);
+
+    m_chips[color] ^= ply.flips | Bitboard::squareBit(ply.square);
+    m_chips[Utils::opponentColorFor(color)] ^= ply.flips;
+    updateLegalMoves();
+
+    return KReversiMove(color, ply.square / 8, ply.square % 8);
+}
+
+MoveList KReversiGame::chipsChangedBy(const Ply &ply)
+{
+    const ChipColor color = ChipColor(ply.color);
+    const int row = ply.square / 8;
+    const int col = ply.square % 8;
+    MoveList chips;
 
     // the first one is the move itself
-    setChipColor(move);
-    m_changedChips.append(move);
-    // now turn color of all chips that were won
+    chips.append(KReversiMove(color, row, col));
+    // then the chips it turned, direction by direction, the nearest first,
+    // which is the order they turn in
     for (int dirNum = 0; dirNum < DIRECTIONS_COUNT; dirNum++) {
-        if (hasChunk(dirNum, move)) {
-            for (int r = move.row + DX[dirNum], c = move.col + DY[dirNum];
-                    r >= 0 && c >= 0 && r < 8 && c < 8;
-                    r += DX[dirNum], c += DY[dirNum]) {
-                if (m_cells[r][c] == move.color)
-                    break;
-                setChipColor(KReversiMove(move.color, r, c));
-                m_changedChips.append(KReversiMove(move.color, r, c));
-            }
-        }
+        for (int r = row + DX[dirNum], c = col + DY[dirNum];
+                r >= 0 && c >= 0 && r < 8 && c < 8
+                && (ply.flips & Bitboard::squareBit(Bitboard::square(r, c)));
+                r += DX[dirNum], c += DY[dirNum])
+            chips.append(KReversiMove(color, r, c));
     }
 
-    m_undoStack.push(m_changedChips);
+    return chips;
 }
 
 bool KReversiGame::isMovePossible(KReversiMove move) const
 {
-    // first - the trivial case:
-    if (m_cells[move.row][move.col] != NoColor || move.color == NoColor)
+    if (!move.isValid())
         return false;
+    return m_legalMoves[move.color] & Bitboard::squareBit(Bitboard::square(move.row, move.col));
+}
 
-    for (int dirNum = 0; dirNum < DIRECTIONS_COUNT; dirNum++)
-        if (hasChunk(dirNum, move))
-            return true;
-
-    return false;
-}
-
-bool KReversiGame::hasChunk(int dirNum, KReversiMove move) const
-{
-    // On each step (as we proceed) we must ensure that current chip is of the
-    // opponent color.
-    // We'll do our steps until we reach the chip of player color or we reach
-    // the end of the board in this direction.
-    // If we found player-colored chip and number of opponent chips between it and
-    // the starting one is greater than zero, then Hurray! we found a chunk
-    //
-    // Well, I wrote this description from my head, now lets produce some code for that ;)
-
-    ChipColor opColor = Utils::opponentColorFor(move.color);
-    int opponentChipsNum = 0;
-    bool foundPlayerColor = false;
-
-    for (int r = move.row + DX[dirNum], c = move.col + DY[dirNum];
-            r >= 0 && c >= 0 && r < 8 && c < 8;
-            r += DX[dirNum], c += DY[dirNum]) {
-        ChipColor color = m_cells[r][c];
-        if (color == opColor) {
-            opponentChipsNum++;
-        } else if (color == move.color) {
-            foundPlayerColor = true;
-            break;
-        } else
-            break;
-    }
-
-    if (foundPlayerColor && opponentChipsNum != 0)
-        return true;
-
-    return false;
+void KReversiGame::updateLegalMoves()
+{
+    m_legalMoves[White] = Bitboard::legalMoves(m_chips[White], m_chips[Black]);
+    m_legalMoves[Black] = Bitboard::legalMoves(m_chips[Black], m_chips[White]);
 }
 
 bool KReversiGame::isGameOver() const
 {
-    // trivial fast-check
-    if (m_score[White] + m_score[Black] == 64)
-        return true; // the board is full
-    else
-        return !(isAnyPlayerMovePossible(White) || isAnyPlayerMovePossible(Black));
+    // a full board leaves no moves either
+    return !(m_legalMoves[White] | m_legalMoves[Black]);
 }
 
 bool KReversiGame::isAnyPlayerMovePossible(ChipColor player) const
 {
-    for (int r = 0; r < 8; ++r)
-        for (int c = 0; c < 8; ++c) {
-            if (m_cells[r][c] == NoColor) {
-                // let's see if we can put chip here
-                if (isMovePossible(KReversiMove(player, r, c)))
-                    return true;
-            }
-        }
-    return false;
+    return player != NoColor && m_legalMoves[player];
 }
 
 void KReversiGame::setDelay(int delay)
@@ -258,20 +239,13 @@ void KReversiGame::setDelay(int delay)
 
 int KReversiGame::getPreAnimationDelay(KReversiPos pos) const
 {
-    for (int i = 1; i < m_changedChips.size(); i++) {
-        if (m_changedChips[i].row == pos.row && m_changedChips[i].col == pos.col) {
-            return (i - 1) * m_delay;
-        }
-    }
-    return 0;
+    return m_turnOrder[Bitboard::square(pos.row, pos.col)] * m_delay;
 }
 
-MoveList KReversiGame::getHistory() const
+KReversiMove KReversiGame::historyMove(int ply) const
 {
-    MoveList l;
-    for (int i = 0; i < m_undoStack.size(); i++)
-        l.push_back(m_undoStack.at(i).at(0));
-    return l;
+    const int square = m_undoLog[ply].square;
+    return KReversiMove(ChipColor(m_undoLog[ply].color), square / 8, square % 8);
 }
 
 bool KReversiGame::isHintAllowed() const
@@ -314,11 +288,76 @@ void KReversiGame::whiteReady()
         m_player[Black]->takeTurn();
 }
 
-KReversiMove KReversiGame::getHint() const
+void KReversiGame::requestHint()
 {
-    /// FIXME: dimsuz: don't use true, use m_competitive
+    // also false once the game is over, when there is no current player
+    if (!isHintAllowed())
+        return;
+
+    const Position current = position();
+    if (m_hintWatcher.isRunning() && !m_hintWatcher.isCanceled() && current == m_hintPosition)
+        return; // a hint is on its way already
+
     m_player[m_curPlayer]->hintUsed();
-    return m_engine->computeMove(*this, true);
+
+    // a hint we had to stop looking for is shown, and improved on
+    const auto known = m_hints.constFind(current);
+    if (known != m_hints.constEnd()) {
+        Q_EMIT hintReady(known->move);
+        if (known->done)
+            return;
+    }
+
+    /// FIXME: dimsuz: don't use true, use m_competitive
+    m_hintPosition = current;
+    m_hintWatcher.setFuture(hintEngine()->startComputeMove(current, true));
+}
+
+Engine *KReversiGame::hintEngine()
+{
+    if (m_engine)
+        return m_engine;
+
+    m_engineService = EngineService::instance();
+    m_engine = m_engineService->createEngine(HINT_STRENGTH);
+    m_engine->setTimeLimit(HINT_TIME);
+    // the engine reports on its search thread, the hint is shown on ours
+    m_engine->setProgressHandler([this](const Position &position, const KReversiMove &move, int) {
+        QMetaObject::invokeMethod(this, [this, position, move]() {
+            hintProgress(position, move);
+        }, Qt::QueuedConnection);
+    });
+    return m_engine;
+}
+
+void KReversiGame::hintProgress(const Position &position, const KReversiMove &move)
+{
+    if (position != m_hintPosition || !m_hintWatcher.isRunning() || m_hintWatcher.isCanceled())
+        return;
+
+    m_hints[position].move = move;
+    Q_EMIT hintReady(move);
+}
+
+void KReversiGame::hintComputed()
+{
+    if (m_hintWatcher.isCanceled())
+        return;
+
+    const KReversiMove hint = m_hintWatcher.result();
+    if (hint.isValid()) {
+        Hint &known = m_hints[m_hintPosition];
+        known.move = hint;
+        known.done = true;
+        Q_EMIT hintReady(hint);
+    }
+}
+
+void KReversiGame::cancelHint()
+{
+    if (m_engine)
+        m_engine->setInterrupt(true);
+    m_hintWatcher.cancel();
 }
 
 KReversiMove KReversiGame::getLastMove() const
@@ -337,36 +376,35 @@ MoveList KReversiGame::possibleMoves() const
     if (m_curPlayer == NoColor) // we are at animation period: no move is possible
         return l;
 
-    for (int r = 0; r < 8; ++r)
-        for (int c = 0; c < 8; ++c) {
-            KReversiMove move(m_curPlayer, r, c);
-            if (isMovePossible(move))
-                l.append(move);
-        }
+    for (quint64 moves = m_legalMoves[m_curPlayer]; moves; moves &= moves - 1) {
+        const int square = Bitboard::firstSquare(moves);
+        l.append(KReversiMove(m_curPlayer, square / 8, square % 8));
+    }
     return l;
 }
 
 int KReversiGame::playerScore(ChipColor player) const
 {
-    return m_score[player];
+    return Bitboard::popCount(m_chips[player]);
 }
 
-void KReversiGame::setChipColor(KReversiMove move)
+ChipColor KReversiGame::chipColorAt(KReversiPos pos) const
 {
-    // first: if the current cell already contains a chip we remove it
-    if (m_cells[move.row][move.col] != NoColor)
-        m_score[m_cells[move.row][move.col]]--;
-
-    // and now replacing with chip of 'color'
-    m_cells[move.row][move.col] = move.color;
-
-    if (move.color != NoColor)
-        m_score[move.color]++;
+    const quint64 bit = Bitboard::squareBit(Bitboard::square(pos.row, pos.col));
+    if (m_chips[White] & bit)
+        return White;
+    if (m_chips[Black] & bit)
+        return Black;
+    return NoColor;
 }
 
-ChipColor KReversiGame::chipColorAt(KReversiPos pos) const
+Position KReversiGame::position() const
 {
-    return m_cells[pos.row][pos.col];
+    Position position;
+    position.black = m_chips[Black];
+    position.white = m_chips[White];
+    position.toMove = m_curPlayer;
+    return position;
 }
 
 
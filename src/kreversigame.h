@@ -8,12 +8,14 @@
 #ifndef KREVERSI_GAME_H
 #define KREVERSI_GAME_H
 
+#include <QFutureWatcher>
+#include <QHash>
 #include <QObject>
-#include <QStack>
 #include <QTimer>
 
 #include "Engine.h"
 #include "commondefs.h"
+#include "engineservice.h"
 #include "kreversiplayer.h"
 
 class Engine;
@@ -57,14 +59,21 @@ public:
      *  @return score (number of chips) of the @p player
      */
     int playerScore(ChipColor player) const;
+    /**
+     *  @return the board and the player to move, as the engine sees them
+     */
+    Position position() const;
     /**
      *  @return color of the chip at position @p pos
      */
     ChipColor chipColorAt(KReversiPos pos) const;
     /**
-     *  @return a hint to current player
+     *  Starts looking for a hint to current player in the background.
+     *  hintReady() is emitted with the best move so far every time the
+     *  search gets one level deeper, and once more when it is done. A
+     *  hint found before for the same position is shown at once.
      */
-    KReversiMove getHint() const;
+    void requestHint();
     /**
      *  @return last move made
      */
@@ -104,9 +113,15 @@ public:
      */
     int getPreAnimationDelay(KReversiPos pos) const;
     /**
-     *  @return History of moves as MoveList
+     *  @return the number of moves made so far. Passes are not moves
+     */
+    int historySize() const {
+        return m_plies;
+    }
+    /**
+     *  @return the move number @p ply of the game, counting from 0
      */
-    MoveList getHistory() const;
+    KReversiMove historyMove(int ply) const;
 
     /**
      *  @return Is hint allowed for current player
@@ -148,8 +163,33 @@ Q_SIGNALS:
     void blackPlayerCantMove();
     void whitePlayerTurn();
     void blackPlayerTurn();
+    /**
+     *  Emitted when the hint asked for with requestHint() is ready or
+     *  has been improved
+     */
+    void hintReady(const KReversiMove &hint);
+    /**
+     *  Emitted when move number @p ply has been added to the history
+     */
+    void historyAppended(int ply);
+    /**
+     *  Emitted when moves have been undone, leaving @p size of them in
+     *  the history
+     */
+    void historyTruncated(int size);
+private Q_SLOTS:
+    /**
+     *  Passes the found hint on, unless the board has changed since
+     */
+    void hintComputed();
 private:
-    // predefined direction arrays for easy implementation
+    /**
+     *  kreversi-perft walks the game tree with isMovePossible() and
+     *  turnChips() to check them against the engine
+     */
+    friend class KReversiGamePerft;
+    // predefined direction arrays, used to list the turned chips in the
+    // order they are animated
     static const int DIRECTIONS_COUNT = 8;
     static const int DX[];
     static const int DY[];
@@ -157,6 +197,20 @@ private:
      *  Used to make player think about his move again after unpossible move
      */
     void kickCurrentPlayer();
+    /**
+     *  Stops looking for a hint, the result will not be shown
+     */
+    void cancelHint();
+    /**
+     *  Shows the best move found so far for @p position, if that is
+     *  still the one a hint is being searched for
+     */
+    void hintProgress(const Position &position, const KReversiMove &move);
+    /**
+     *  @return m_engine, set up on the first call, so that games that
+     *  never give a hint (and kreversi-perft) need no engine
+     */
+    Engine *hintEngine();
     /**
      *  This will make the player @p move
      *  If that is possible, of course
@@ -167,24 +221,40 @@ private:
      */
     bool isMovePossible(KReversiMove move) const;
     /**
-     *  Searches for "chunk" in direction @p dirNum for @p move.
-     *  As my English-skills are somewhat limited, let me introduce
-     *  new terminology ;).
-     *  I'll define a "chunk" of chips for color "C" as follows:
-     *  (let "O" be the color of the opponent for color "C")
-     *  CO[O]C <-- this is a chunk
-     *  where [O] is one or more opponent's pieces
+     *  A move as the undo log keeps it: the square, who played it and
+     *  the chips it turned
      */
-    bool hasChunk(int dirNum, KReversiMove move) const;
+    struct Ply {
+        quint64 flips;
+        qint8 square;
+        qint8 color;
+    };
+    /**
+     *  Every move fills a square, so there are never more moves than this
+     */
+    static const int MAX_PLIES = 60;
     /**
      *  Performs @p move, i.e. marks all the chips that player wins with
      *  this move with current player color
      */
     void turnChips(KReversiMove move);
     /**
-     *  Sets the type of chip according to @p move
+     *  Takes back the last move in the undo log
+     *  @return the move taken back
+     */
+    KReversiMove takeBackPly();
+    /**
+     *  @return the chips changed by @p ply, in the order of m_changedChips
+     */
+    static MoveList chipsChangedBy(const Ply &ply);
+    /**
+     *  Sets m_changedChips to @p chips and m_turnOrder to match
      */
-    void setChipColor(KReversiMove move);
+    void setChangedChips(const MoveList &chips);
+    /**
+     *  Finds the moves each color could make on the board as it is now
+     */
+    void updateLegalMoves();
     /**
      *  Delay time
      */
@@ -198,17 +268,44 @@ private:
      */
     ChipColor m_lastPlayer;
     /**
-     *  The board itself
+     *  The board itself: a bitboard of the chips of each color, indexed
+     *  by ChipColor (see bitboard.h)
      */
-    ChipColor m_cells[8][8];
+    quint64 m_chips[2];
     /**
-     *  Score of each player
+     *  The squares each color could move to, found by updateLegalMoves()
+     *  whenever the board changes, so that looking for moves, passes and
+     *  the end of the game costs next to nothing
      */
-    int m_score[2];
+    quint64 m_legalMoves[2];
     /**
-     *  AI to give hints
+     *  Handle to the service m_engine comes from
+     */
+    QSharedPointer<EngineService> m_engineService;
+    /**
+     *  AI to give hints, null until hintEngine() sets it up
      */
     Engine *m_engine;
+    /**
+     *  Watches the hint search started by requestHint()
+     */
+    QFutureWatcher<KReversiMove> m_hintWatcher;
+    /**
+     *  The position the last hint was asked for
+     */
+    Position m_hintPosition;
+    /**
+     *  A hint found for a position, @c done once its search has run to
+     *  the end rather than being cut short
+     */
+    struct Hint {
+        KReversiMove move;
+        bool done = false;
+    };
+    /**
+     *  The hints found in this game so far
+     */
+    QHash<Position, Hint> m_hints;
     /**
      *  Color of the current player.
      *  @c NoColor if it is interchange for animations
@@ -222,11 +319,21 @@ private:
      */
     MoveList m_changedChips;
     /**
-     *  This is an undo stack.
-     *  It contains a lists of chips changed with each turn.
-     *  @see m_changedChips
+     *  For each square (see bitboard.h), the number of chips turned before
+     *  the one on it by the last move, 0 if that move did not turn it.
+     *  Filled along with m_changedChips, so that getPreAnimationDelay()
+     *  is a lookup
+     */
+    qint8 m_turnOrder[64];
+    /**
+     *  This is the undo log: the moves made so far, oldest first.
+     *  Taking one back is just turning its chips back
+     */
+    Ply m_undoLog[MAX_PLIES];
+    /**
+     *  Number of moves in m_undoLog
      */
-    QStack<MoveList> m_undoStack;
+    int m_plies;
     /**
      *  Used to handle end of player's animations or other stuff
      */
@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2006 Dmitry Suzdalev <dimsuz@gmail.com>
+    SPDX-FileCopyrightText: 2013 Denis Kuplyakov <dener.kup@gmail.com>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_MOVE_H
+#define KREVERSI_MOVE_H
+
+#include <QList>
+
+// The chips, squares and moves shared by the engine and the game.  Only
+// needs QtCore, so that the engine library can use it (see commondefs.h
+// for the rest).
+
+/**
+ * Used to indicate chip's state.
+ */
+enum ChipColor {
+    /** White state */
+    White = 0,
+    /** Black state */
+    Black = 1,
+    /** No chip (empty cell) */
+    NoColor = 2
+};
+
+static const int nRows = 8;
+static const int nCols = 8;
+
+/**
+ * Represents position on board.
+ */
+struct KReversiPos {
+    KReversiPos(int r = -1, int c = -1)
+        : row(r), col(c) { }
+
+    int row;
+    int col;
+
+    bool isValid() const {
+        return (row >= 0 && col >= 0 && row < nRows && col < nCols);
+    }
+};
+
+/**
+ * Represents move of player.
+ * It is KReversiPos + ChipColor
+ */
+struct KReversiMove: public KReversiPos {
+    KReversiMove(ChipColor col = NoColor, int r = -1, int c = -1)
+        : KReversiPos(r, c), color(col) { }
+
+    KReversiMove(ChipColor col, KReversiPos pos)
+        : KReversiPos(pos), color(col) { }
+
+    ChipColor color;
+
+    bool isValid() const {
+        return (color != NoColor
+                && row >= 0 && col >= 0
+                && row < nRows && col < nCols);
+    }
+};
+
+typedef QList<KReversiMove> MoveList;
+
+namespace Utils
+{
+/**
+ * Return opposite color for @p color
+ * @return @c Black for @c White
+ *         @c White for @c Black
+ *         @c NoColor for @c NoColor
+ */
+inline ChipColor opponentColorFor(ChipColor color)
+{
+    if (color == NoColor)
+        return NoColor;
+    else
+        return (color == White ? Black : White);
+}
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 KReversiView::KReversiView(KReversiGame* game, QWidget *parent, KgThemeProvider *provider)
     : KgDeclarativeView(parent),
+    m_boardModel(new KReversiBoardModel(this)),
     m_provider(provider),
     m_delay(ANIMATION_SPEED_NORMAL),
     m_game(nullptr),
@@ -25,6 +26,7 @@ KReversiView::KReversiView(KReversiGame* game, QWidget *parent, KgThemeProvider
     m_provider->setDeclarativeEngine(QStringLiteral("themeProvider"), engine());
 
     qmlRegisterType<ColorScheme>("ColorScheme", 1, 0, "ColorScheme");
+    rootContext()->setContextProperty(QStringLiteral("boardModel"), m_boardModel);
 
     QString path = QStandardPaths::locate(QStandardPaths::AppDataLocation, QStringLiteral("qml/Table.qml"));
     setSource(QUrl::fromLocalFile(path));
@@ -48,6 +50,7 @@ void KReversiView::setGame(KReversiGame *game)
         disconnect(m_game, &KReversiGame::gameOver, this, &KReversiView::gameOver);
         disconnect(m_game, &KReversiGame::whitePlayerCantMove, this, &KReversiView::whitePlayerCantMove);
         disconnect(m_game, &KReversiGame::blackPlayerCantMove, this, &KReversiView::blackPlayerCantMove);
+        disconnect(m_game, &KReversiGame::hintReady, this, &KReversiView::showHint);
         delete m_game;
     }
 
@@ -59,6 +62,7 @@ void KReversiView::setGame(KReversiGame *game)
         connect(m_game, &KReversiGame::gameOver, this, &KReversiView::gameOver);
         connect(m_game, &KReversiGame::whitePlayerCantMove, this, &KReversiView::whitePlayerCantMove);
         connect(m_game, &KReversiGame::blackPlayerCantMove, this, &KReversiView::blackPlayerCantMove);
+        connect(m_game, &KReversiGame::hintReady, this, &KReversiView::showHint);
 
         m_game->setDelay(m_delay);
     }
@@ -112,82 +116,39 @@ KReversiView::~KReversiView()
 
 void KReversiView::updateBoard()
 {
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            QMetaObject::invokeMethod(m_qml_root, "setPreAnimationTime",
-                                      Q_ARG(QVariant, i),
-                                      Q_ARG(QVariant, j),
-                                      Q_ARG(QVariant, m_game ? m_game->getPreAnimationDelay(KReversiPos(i, j)) : 0));
+    KReversiBoardModel::Cell cells[KReversiBoardModel::CELL_COUNT];
+
+    if (m_game) { // showing empty board if has no game
+        for (int i = 0; i < 8; i++)
+            for (int j = 0; j < 8; j++) {
+                KReversiBoardModel::Cell &cell = cells[i * 8 + j];
+                cell.color = m_game->chipColorAt(KReversiPos(i, j));
+                cell.preAnimationTime = m_game->getPreAnimationDelay(KReversiPos(i, j));
+            }
+
+        if (m_showLegalMoves) {
+            const MoveList possible_moves = m_game->possibleMoves();
+            for (int i = 0; i < possible_moves.size(); i++)
+                cells[possible_moves.at(i).row * 8 + possible_moves.at(i).col].isLegal = true;
         }
     }
 
-    for (int i = 0; i < 8; i++)
-        for (int j = 0; j < 8; j++) {
-            QString new_state;
-            if (m_game) // showing empty board if has no game
-                switch (m_game->chipColorAt(KReversiMove(NoColor, i, j))) {
-                case Black:
-                    new_state = QStringLiteral("Black");
-                    break;
-                case White:
-                    new_state = QStringLiteral("White");
-                    break;
-                case NoColor:
-                    new_state = QString();
-                    break;
-                }
-
-            QMetaObject::invokeMethod(m_qml_root, "setChipState",
-                                      Q_ARG(QVariant, i),
-                                      Q_ARG(QVariant, j),
-                                      Q_ARG(QVariant, new_state));
-
-            // clearing legal markers, hints and lastmove
-            QMetaObject::invokeMethod(m_qml_root, "setLegal",
-                                      Q_ARG(QVariant, i),
-                                      Q_ARG(QVariant, j),
-                                      Q_ARG(QVariant, false));
-            QMetaObject::invokeMethod(m_qml_root, "setHint",
-                                      Q_ARG(QVariant, i),
-                                      Q_ARG(QVariant, j),
-                                      Q_ARG(QVariant, false));
-            QMetaObject::invokeMethod(m_qml_root, "setLastMove",
-                                      Q_ARG(QVariant, i),
-                                      Q_ARG(QVariant, j),
-                                      Q_ARG(QVariant, false));
-        }
-
-    if (m_game && m_showLegalMoves) {
-        MoveList possible_moves = m_game->possibleMoves();
-        for (int i = 0; i < possible_moves.size(); i++) {
-            QMetaObject::invokeMethod(m_qml_root, "setLegal",
-                                      Q_ARG(QVariant, possible_moves.at(i).row),
-                                      Q_ARG(QVariant, possible_moves.at(i).col),
-                                      Q_ARG(QVariant, true));
-        }
-    }
-
-    m_qml_root->setProperty("isBoardShowingLabels", m_showLabels);
-
     if (m_hint.isValid()) {
-        QMetaObject::invokeMethod(m_qml_root, "setChipState",
-                                  Q_ARG(QVariant, m_hint.row),
-                                  Q_ARG(QVariant, m_hint.col),
-                                  Q_ARG(QVariant, QLatin1String("Black")));
-        QMetaObject::invokeMethod(m_qml_root, "setHint",
-                                  Q_ARG(QVariant, m_hint.row),
-                                  Q_ARG(QVariant, m_hint.col),
-                                  Q_ARG(QVariant, true));
+        KReversiBoardModel::Cell &cell = cells[m_hint.row * 8 + m_hint.col];
+        cell.color = Black;
+        cell.isHint = true;
     }
 
     if (m_game && m_showLastMove) {
         KReversiMove lastmove = m_game->getLastMove();
         if (lastmove.isValid())
-            QMetaObject::invokeMethod(m_qml_root, "setLastMove",
-                                      Q_ARG(QVariant, lastmove.row),
-                                      Q_ARG(QVariant, lastmove.col),
-                                      Q_ARG(QVariant, true));
+            cells[lastmove.row * 8 + lastmove.col].isLastMove = true;
     }
+
+    // only the cells which differ from the shown ones reach QML
+    m_boardModel->setCells(cells);
+
+    m_qml_root->setProperty("isBoardShowingLabels", m_showLabels);
 }
 
 void KReversiView::setShowLastMove(bool show)
@@ -209,7 +170,12 @@ void KReversiView::slotHint()
         return;
     }
 
-    m_hint = m_game->getHint();
+    m_game->requestHint();
+}
+
+void KReversiView::showHint(const KReversiMove &hint)
+{
+    m_hint = hint;
     updateBoard();
 }
 
@@ -13,6 +13,7 @@
 #include <KgDeclarativeView>
 #include <KgThemeProvider>
 
+#include "boardmodel.h"
 #include "commondefs.h"
 #include "kreversigame.h"
 
@@ -97,6 +98,10 @@ private Q_SLOTS:
      *  Synchronizes graphical board with m_game's board
      */
     void updateBoard();
+    /**
+     *  Marks @p hint on the board, connected to KReversiGame::hintReady
+     */
+    void showHint(const KReversiMove &hint);
     void gameMoveFinished();
     void gameOver();
     void whitePlayerCantMove();
@@ -125,6 +130,11 @@ private:
      */
     QObject *m_qml_root;
 
+    /**
+     *  Cells shown by the QML board
+     */
+    KReversiBoardModel *m_boardModel;
+
     /**
      *  Used to access theme engine from QML
      */
@@ -33,6 +33,7 @@ KReversiMainWindow::KReversiMainWindow(QWidget* parent, bool startDemo)
     m_game(nullptr),
     m_historyDock(nullptr),
     m_historyView(nullptr),
+    m_historyModel(nullptr),
     m_firstShow(true),
     m_startInDemoMode(startDemo),
     m_undoAct(nullptr),
@@ -61,7 +62,9 @@ KReversiMainWindow::KReversiMainWindow(QWidget* parent, bool startDemo)
     Kg::difficulty()->setEditable(false);
 
     // initialize history dock
-    m_historyView = new QListWidget(this);
+    m_historyModel = new KReversiHistoryModel(this);
+    m_historyView = new QListView(this);
+    m_historyView->setModel(m_historyModel);
     m_historyView->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Expanding);
     m_historyDock = new QDockWidget(i18n("Move History"));
     m_historyDock->setWidget(m_historyView);
@@ -293,17 +296,10 @@ void KReversiMainWindow::slotMoveFinished()
 
 void KReversiMainWindow::updateHistory()
 {
-    MoveList history = m_game->getHistory();
-    m_historyView->clear();
-
-    for (int i = 0; i < history.size(); i++) {
-        QString numStr = QString::number(i + 1) + QStringLiteral(". ");
-        m_historyView->addItem(numStr + Utils::moveToString(history.at(i)));
-    }
-
-    QListWidgetItem *last = m_historyView->item(m_historyView->count() - 1);
-    m_historyView->setCurrentItem(last);
-    m_historyView->scrollToItem(last);
+    // the model follows the game by itself, only show its last move
+    const QModelIndex last = m_historyModel->index(m_historyModel->rowCount() - 1);
+    m_historyView->setCurrentIndex(last);
+    m_historyView->scrollTo(last);
 }
 
 void KReversiMainWindow::slotUndo()
@@ -400,8 +396,15 @@ void KReversiMainWindow::receivedGameStartInformation(const GameStartInformation
             m_player[i] = new KReversiHumanPlayer(ChipColor(i), info.name[i]);
         }
 
+    // two computers, as in the demo, would ponder against each other
+    if (info.type[Black] == GameStartInformation::AI && info.type[White] == GameStartInformation::AI)
+        for (int i = 0; i < 2; i++)
+            ((KReversiComputerPlayer *)(m_player[i]))->setPonderAllowed(false);
+
     m_game = new KReversiGame(m_player[Black], m_player[White]);
 
+    // the view deletes the old game, so the model must let go of it first
+    m_historyModel->setGame(m_game);
     m_view->setGame(m_game);
 
     connect(m_game, &KReversiGame::gameOver, this, &KReversiMainWindow::slotGameOver);
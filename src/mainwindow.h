@@ -10,7 +10,7 @@
 
 
 #include <QDockWidget>
-#include <QListWidget>
+#include <QListView>
 
 #include <KSelectAction>
 #include <KToggleAction>
@@ -19,6 +19,7 @@
 #include "preferences.h"
 #include "startgamedialog.h"
 
+#include "historymodel.h"
 #include "kreversigame.h"
 #include "kreversiview.h"
 
@@ -65,7 +66,8 @@ private:
     KReversiView  *m_view;
     KReversiGame  *m_game;
     QDockWidget   *m_historyDock;
-    QListWidget   *m_historyView;
+    QListView     *m_historyView;
+    KReversiHistoryModel *m_historyModel;
 
     bool m_firstShow;
     bool m_startInDemoMode;
@@ -0,0 +1,400 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// kreversi-engine: the KReversi engine without the game around it, for
+// analysis in scripts and for programs such as NBoard. It reads commands
+// from the standard input, one per line, and writes the answers to the
+// standard output. It needs no display and registers no services, so
+// any number of them can run side by side.
+//
+// The commands are those of the NBoard protocol, version 2:
+//
+//   nboard <version>       answered with "set myname KReversi"
+//   set depth <moves>      search <moves> moves ahead (1 to 60); a depth
+//                          that reaches the end of the game solves it
+//   set game <ggf>         start from the game in <ggf>, a game record
+//                          in the Generic Game Format
+//   set contempt <n>       ignored
+//   move <move>[/<eval>[/<seconds>]]
+//                          play <move> (such as f5, or PA to pass)
+//   go                     search for a move, answered with
+//                          "=== <move>/<eval>/<seconds>"
+//   hint <n>               the <n> best moves, one line each, as
+//                          "search <moves> <eval> 0 <depth>", then
+//                          "status"; <moves> are the move and the best
+//                          replies, such as "F5D6C3"
+//   ping <n>               throw away the running search, answered with
+//                          "pong <n>"
+//   learn                  answered with "learned"
+//   analyze                ignored
+//
+// Evaluations are in discs for the player to move. The depth of an exact
+// result is the number of empty squares, followed by "@100%". "go" and
+// "hint" also answer "nodestats <nodes> <seconds>" when they are done.
+//
+// KReversi also understands:
+//
+//   set time <msecs>       stop searching after <msecs> milliseconds,
+//                          0 for no limit (default 3000)
+//   set hash <megabytes>   the size of the transposition table (64)
+//   set threads <count>    search with <count> threads (1)
+//   stop                   end the running search, answering with what
+//                          it has found so far
+//   quit                   exit once the running search is done, as
+//                          at the end of the input
+//
+// Searches run in the background, so "stop" and "ping" are seen while
+// the engine thinks. Any other command waits until the search is done.
+// Lines that are not understood are reported on the standard error.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <limits>
+
+#include "Engine.h"
+#include "bitboard.h"
+#include "obf.h"
+
+namespace
+{
+
+// The strength the engine plays with.  Its depth and time limits are
+// replaced by "set depth" and "set time".
+const int ENGINE_STRENGTH = 6;
+
+const int DEFAULT_TIME = 3000;
+const int DEFAULT_HASH = 64;
+
+// A move with what the search found out about it, in the terms of the
+// protocol.
+struct Result {
+    int     square;
+    int     value;
+    int     depth;
+    bool    exact;
+    QString variation;
+};
+
+QString squareName(int square)
+{
+    if (square < 0)
+        return QStringLiteral("PA");
+    return QString(QLatin1Char(char('A' + square % 8))) + QLatin1Char(char('1' + square / 8));
+}
+
+// The square of a move such as "f5" or "F5/1.00/0.1", -1 for a pass or
+// -2 if it is not a move.
+int parseSquare(const QString &text)
+{
+    const QString move = text.section(QLatin1Char('/'), 0, 0).trimmed().toUpper();
+    if (move == QLatin1String("PA") || move == QLatin1String("PASS"))
+        return -1;
+    if (move.size() != 2 || move.at(0) < QLatin1Char('A') || move.at(0) > QLatin1Char('H')
+            || move.at(1) < QLatin1Char('1') || move.at(1) > QLatin1Char('8'))
+        return -2;
+    return Bitboard::square(move.at(1).unicode() - '1', move.at(0).unicode() - 'A');
+}
+
+// Play square (-1 to pass) for the player to move in position, if that
+// is a legal move for them.
+bool playMove(Position &position, int square)
+{
+    const quint64 legal = Bitboard::legalMoves(position.player(), position.opponent());
+    if (square < 0) {
+        if (legal)
+            return false;
+        position.toMove = Utils::opponentColorFor(position.toMove);
+        return true;
+    }
+
+    if (!(legal & Bitboard::squareBit(square)))
+        return false;
+
+    position.play(square);
+    return true;
+}
+
+// Like playMove(), but if the player to move cannot move and the other
+// one can play square, the pass that was left out is played first.
+bool play(Position &position, int square)
+{
+    if (square >= 0 && !Bitboard::legalMoves(position.player(), position.opponent()))
+        position.toMove = Utils::opponentColorFor(position.toMove);
+    return playMove(position, square);
+}
+
+// Set up position from a game record in the Generic Game Format, such as
+// (;GM[Othello]PB[a]PW[b]TY[8]BO[8 ---...--- *]B[d3//1.5]W[c5];).  Only
+// the start position (BO) and the moves (B and W) matter.
+bool parseGame(const QString &ggf, Position &position, QString &error)
+{
+    static const QRegularExpression property(QStringLiteral("([A-Z]+)\\[([^\\]]*)\\]"));
+
+    bool board = false;
+    QRegularExpressionMatchIterator it = property.globalMatch(ggf);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        const QString name = match.captured(1);
+        const QString value = match.captured(2);
+
+        if (name == QLatin1String("TY") && !value.trimmed().startsWith(QLatin1Char('8'))) {
+            error = QStringLiteral("only 8x8 boards are supported");
+            return false;
+        } else if (name == QLatin1String("BO")) {
+            QString obf = value.trimmed();
+            if (!obf.startsWith(QLatin1Char('8'))) {
+                error = QStringLiteral("only 8x8 boards are supported");
+                return false;
+            }
+            QString boardName;
+            if (!Obf::parse(obf.mid(1), position, boardName, error))
+                return false;
+            board = true;
+        } else if (name == QLatin1String("B") || name == QLatin1String("W")) {
+            if (!board) {
+                error = QStringLiteral("moves before the board");
+                return false;
+            }
+            // the record says who moves, so a pass is never left out
+            const int square = parseSquare(value);
+            position.toMove = (name == QLatin1String("B")) ? Black : White;
+            if (square >= 0 && !Bitboard::legalMoves(position.player(), position.opponent())) {
+                error = QStringLiteral("%1 cannot move, illegal move %2").arg(name, value);
+                return false;
+            }
+            if (square < -1 || !playMove(position, square)) {
+                error = QStringLiteral("illegal move %1").arg(value);
+                return false;
+            }
+        }
+    }
+
+    if (!board) {
+        error = QStringLiteral("no board (BO)");
+        return false;
+    }
+    return true;
+}
+
+}
+
+// Keeps the game and runs the searches asked for, one at a time.
+
+class NBoardEngine
+{
+public:
+    NBoardEngine();
+    ~NBoardEngine();
+
+    // Handle one line of input, return false after "quit".  The running
+    // search is waited for when the engine is destroyed.
+    bool command(const QString &line);
+
+private:
+    void startSearch(int moves);
+    void search(int moves);
+    Result searchPosition(const Position &position);
+    void waitForSearch();
+
+    QTextStream         m_out;
+    QTextStream         m_err;
+    Engine              m_engine;
+    Position            m_position;
+    QFuture<void>       m_search;
+    std::atomic<bool>   m_discarded;
+};
+
+NBoardEngine::NBoardEngine()
+    : m_out(stdout)
+    , m_err(stderr)
+    , m_engine(ENGINE_STRENGTH, 1)
+    , m_position(Position::start())
+    , m_discarded(false)
+{
+    m_engine.setTimeLimit(DEFAULT_TIME);
+    m_engine.setHashTableSize(DEFAULT_HASH);
+}
+
+NBoardEngine::~NBoardEngine()
+{
+    waitForSearch();
+}
+
+bool NBoardEngine::command(const QString &line)
+{
+    const QString name = line.section(QLatin1Char(' '), 0, 0, QString::SectionSkipEmpty);
+    const QString argument = line.section(QLatin1Char(' '), 1, -1, QString::SectionSkipEmpty);
+
+    // These are handled while a search runs.
+    if (name.isEmpty()) {
+        return true;
+    } else if (name == QLatin1String("stop")) {
+        m_engine.stop();
+        return true;
+    } else if (name == QLatin1String("ping")) {
+        m_discarded = true;
+        m_engine.setInterrupt(true);
+        waitForSearch();
+        m_out << "pong " << argument << '\n';
+        m_out.flush();
+        return true;
+    }
+
+    waitForSearch();
+
+    if (name == QLatin1String("quit")) {
+        return false;
+    } else if (name == QLatin1String("nboard")) {
+        m_out << "set myname KReversi\n";
+    } else if (name == QLatin1String("set")) {
+        const QString option = argument.section(QLatin1Char(' '), 0, 0);
+        const QString value = argument.section(QLatin1Char(' '), 1);
+        if (option == QLatin1String("depth")) {
+            m_engine.setDepthLimit(qBound(1, value.toInt(), 60));
+        } else if (option == QLatin1String("time")) {
+            const int msecs = value.toInt();
+            m_engine.setTimeLimit(msecs > 0 ? msecs : std::numeric_limits<int>::max());
+        } else if (option == QLatin1String("hash")) {
+            m_engine.setHashTableSize(qMax(value.toInt(), 1));
+        } else if (option == QLatin1String("threads")) {
+            m_engine.setThreads(value.toInt());
+        } else if (option == QLatin1String("game")) {
+            Position position;
+            QString error;
+            if (parseGame(value, position, error))
+                m_position = position;
+            else
+                m_err << "set game: " << error << '\n';
+        } else if (option != QLatin1String("contempt")) {
+            m_err << "unknown option: " << option << '\n';
+        }
+    } else if (name == QLatin1String("move")) {
+        const int square = parseSquare(argument);
+        if (square < -1 || !play(m_position, square))
+            m_err << "illegal move: " << argument << '\n';
+    } else if (name == QLatin1String("go")) {
+        startSearch(0);
+    } else if (name == QLatin1String("hint")) {
+        startSearch(qMax(argument.toInt(), 1));
+    } else if (name == QLatin1String("learn")) {
+        m_out << "learned\n";
+    } else if (name != QLatin1String("analyze")) {
+        m_err << "unknown command: " << line << '\n';
+    }
+
+    m_out.flush();
+    m_err.flush();
+    return true;
+}
+
+// Search for the best move ("go", moves is 0) or for the best moves
+// ("hint") in the background.
+
+void NBoardEngine::startSearch(int moves)
+{
+    // Cleared here and not on the search thread, so that a "ping" or
+    // "stop" right after this is seen however late the search starts.
+    m_discarded = false;
+    m_engine.clearInterrupt();
+    m_search = QtConcurrent::run([this, moves]() {
+        search(moves);
+    });
+}
+
+void NBoardEngine::waitForSearch()
+{
+    m_search.waitForFinished();
+}
+
+void NBoardEngine::search(int moves)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const quint64 legal = Bitboard::legalMoves(m_position.player(), m_position.opponent());
+    QVector<Result> results;
+
+    if (moves == 0 || !legal) {
+        results.append(searchPosition(m_position));
+    } else {
+        const QVector<Engine::MoveAnalysis> analysis = m_engine.analyze(m_position, moves);
+        for (const Engine::MoveAnalysis &move : analysis) {
+            // Where the same player moves twice, the other one passed.
+            QString variation;
+            ChipColor color = move.move.color;
+            for (const KReversiMove &next : move.variation) {
+                if (next.color != color)
+                    variation += squareName(-1);
+                variation += squareName(Bitboard::square(next.row, next.col));
+                color = Utils::opponentColorFor(next.color);
+            }
+            results.append({ Bitboard::square(move.move.row, move.move.col), move.value,
+                             move.depth, move.exact, variation });
+        }
+    }
+
+    if (m_discarded)
+        return;
+
+    const double seconds = timer.elapsed() / 1000.0;
+    const int empties = 64 - Bitboard::popCount(m_position.black | m_position.white);
+    m_out << "nodestats " << m_engine.nodesSearched() << ' ' << seconds << '\n';
+
+    if (moves == 0) {
+        const Result &result = results.first();
+        m_out << "=== " << squareName(result.square) << '/' << result.value / 100.0
+              << '/' << seconds << '\n';
+    } else {
+        for (const Result &result : qAsConst(results)) {
+            m_out << "search " << result.variation << ' ' << result.value / 100.0 << " 0 ";
+            if (result.exact)
+                m_out << empties << "@100%";
+            else
+                m_out << result.depth;
+            m_out << '\n';
+        }
+        m_out << "status\n";
+    }
+    m_out.flush();
+}
+
+// The best move in position and its value, for the player to move.
+
+Result NBoardEngine::searchPosition(const Position &position)
+{
+    const KReversiMove move = m_engine.computeMove(position, true);
+    const int square = move.isValid() ? Bitboard::square(move.row, move.col) : -1;
+    return { square, m_engine.moveValue(), m_engine.moveDepth(), m_engine.moveExact(),
+             squareName(square) };
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kreversi-engine"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("The KReversi engine, speaking the NBoard protocol on the standard input and output."));
+    parser.addHelpOption();
+    parser.process(application);
+
+    NBoardEngine engine;
+    QTextStream in(stdin);
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (!engine.command(line))
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "obf.h"
+
+#include "bitboard.h"
+
+bool Obf::parse(const QString &line, Position &position, QString &name, QString &error)
+{
+    const QString board = line.section(QLatin1Char(';'), 0, 0).simplified().remove(QLatin1Char(' '));
+    if (board.size() != 65) {
+        error = QStringLiteral("expected 64 squares and the player to move");
+        return false;
+    }
+
+    position = Position();
+    for (int square = 0; square < 64; ++square) {
+        const QChar c = board.at(square).toUpper();
+        if (c == QLatin1Char('X') || c == QLatin1Char('*'))
+            position.black |= Bitboard::squareBit(square);
+        else if (c == QLatin1Char('O'))
+            position.white |= Bitboard::squareBit(square);
+        else if (c != QLatin1Char('-') && c != QLatin1Char('.')) {
+            error = QStringLiteral("unknown square '%1'").arg(c);
+            return false;
+        }
+    }
+
+    const QChar toMove = board.at(64).toUpper();
+    if (toMove == QLatin1Char('X') || toMove == QLatin1Char('*'))
+        position.toMove = Black;
+    else if (toMove == QLatin1Char('O'))
+        position.toMove = White;
+    else {
+        error = QStringLiteral("unknown player to move '%1'").arg(toMove);
+        return false;
+    }
+
+    name = line.section(QLatin1Char(';'), 1).trimmed();
+    return true;
+}
+
+QString Obf::format(const Position &position)
+{
+    QString line;
+    for (int square = 0; square < 64; ++square) {
+        switch (position.chipColorAt(square)) {
+        case Black:
+            line += QLatin1Char('X');
+            break;
+        case White:
+            line += QLatin1Char('O');
+            break;
+        default:
+            line += QLatin1Char('-');
+        }
+    }
+    line += QLatin1Char(' ');
+    line += QLatin1Char(position.toMove == White ? 'O' : 'X');
+    return line;
+}
@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_OBF_H
+#define KREVERSI_OBF_H
+
+#include <QString>
+
+#include "position.h"
+
+/**
+ *  Reading positions in the format of the FFO endgame test suite (.obf
+ *  files), used by the benchmark and perft tools.
+ *
+ *  A position is one line: the 64 squares row by row starting at a1,
+ *  'X' for black, 'O' for white and '-' for an empty square, then the
+ *  player to move ('X' or 'O'), optionally followed by ';' and a name.
+ *  Spaces are ignored, and '*' and '.' are accepted for 'X' and '-'.
+ */
+namespace Obf
+{
+/**
+ *  Parses one line into @p position, and its name (if any) into @p name.
+ *  @return @c false with a message in @p error if it is not a position
+ */
+bool parse(const QString &line, Position &position, QString &name, QString &error);
+
+/**
+ *  @return @p position as one line, without a name
+ */
+QString format(const Position &position);
+}
+
+#endif
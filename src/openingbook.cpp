@@ -0,0 +1,170 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "openingbook.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include "bitboard.h"
+
+static const char BOOK_MAGIC[8] = { 'K', 'R', 'V', 'B', 'O', 'O', 'K', '\0' };
+static const quint32 BOOK_VERSION = 1;
+static const int HEADER_SIZE = 16;
+static const int ENTRY_SIZE = 16;
+
+static_assert(sizeof(OpeningBook::Entry) == ENTRY_SIZE, "entries are mapped from the file");
+
+OpeningBook::OpeningBook()
+    : m_entries(nullptr), m_size(0)
+{
+}
+
+OpeningBook::~OpeningBook()
+{
+    close();
+}
+
+bool OpeningBook::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = m_file.size();
+    const uchar *data = fileSize >= HEADER_SIZE ? m_file.map(0, fileSize) : nullptr;
+    if (!data) {
+        m_file.close();
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(data + 8);
+    const quint32 count = qFromLittleEndian<quint32>(data + 12);
+    if (memcmp(data, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 || version != BOOK_VERSION
+            || fileSize != HEADER_SIZE + qint64(count) * ENTRY_SIZE) {
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        return false;
+    }
+
+    m_entries = data + HEADER_SIZE;
+    m_size = int(count);
+    return true;
+}
+
+void OpeningBook::close()
+{
+    if (m_entries)
+        m_file.unmap(const_cast<uchar *>(m_entries - HEADER_SIZE));
+    m_file.close();
+    m_entries = nullptr;
+    m_size = 0;
+}
+
+quint64 OpeningBook::moves(quint64 player, quint64 opponent) const
+{
+    if (!m_entries)
+        return 0;
+
+    const int symmetries = canonicalize(player, opponent);
+    const Entry *entry = find(key(player, opponent));
+    if (!entry)
+        return 0;
+
+    // map the move back through every symmetry that gives the canonical
+    // position, so that symmetric positions get all equivalent moves
+    const quint64 move = Bitboard::squareBit(entry->move & 63);
+    quint64 result = 0;
+    for (int s = 0; s < Bitboard::SymmetryCount; ++s) {
+        if (symmetries & (1 << s))
+            result |= Bitboard::transform(move, Bitboard::inverse(s));
+    }
+    return result;
+}
+
+int OpeningBook::canonicalize(quint64 &player, quint64 &opponent)
+{
+    quint64 bestPlayer = player;
+    quint64 bestOpponent = opponent;
+    int symmetries = 1 << Bitboard::Identity;
+
+    for (int s = Bitboard::Identity + 1; s < Bitboard::SymmetryCount; ++s) {
+        const quint64 p = Bitboard::transform(player, s);
+        const quint64 o = Bitboard::transform(opponent, s);
+        if (p < bestPlayer || (p == bestPlayer && o < bestOpponent)) {
+            bestPlayer = p;
+            bestOpponent = o;
+            symmetries = 1 << s;
+        } else if (p == bestPlayer && o == bestOpponent) {
+            symmetries |= 1 << s;
+        }
+    }
+
+    player = bestPlayer;
+    opponent = bestOpponent;
+    return symmetries;
+}
+
+quint64 OpeningBook::key(quint64 player, quint64 opponent)
+{
+    // part of the file format, must never change
+    quint64 hash = player * 0x9e3779b97f4a7c15ULL
+                   ^ (opponent + 0x632be59bd9b4e019ULL) * 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 31;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+const OpeningBook::Entry *OpeningBook::find(quint64 key) const
+{
+    // the entries are naturally aligned in the mapped file, but are stored
+    // in little endian
+    const Entry *begin = reinterpret_cast<const Entry *>(m_entries);
+    const Entry *end = begin + m_size;
+    const Entry *entry = std::lower_bound(begin, end, key, [](const Entry &e, quint64 k) {
+        return qFromLittleEndian(e.key) < k;
+    });
+    if (entry == end || qFromLittleEndian(entry->key) != key)
+        return nullptr;
+    return entry;
+}
+
+bool OpeningBook::save(const QString &fileName, QVector<Entry> entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.key < b.key;
+    });
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    uchar header[HEADER_SIZE];
+    memcpy(header, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    qToLittleEndian<quint32>(BOOK_VERSION, header + 8);
+    qToLittleEndian<quint32>(quint32(entries.size()), header + 12);
+    if (file.write(reinterpret_cast<const char *>(header), HEADER_SIZE) != HEADER_SIZE)
+        return false;
+
+    for (const Entry &entry : qAsConst(entries)) {
+        uchar data[ENTRY_SIZE];
+        qToLittleEndian<quint64>(entry.key, data);
+        qToLittleEndian<quint32>(entry.games, data + 8);
+        qToLittleEndian<qint16>(entry.score, data + 12);
+        data[14] = entry.move;
+        data[15] = 0;
+        if (file.write(reinterpret_cast<const char *>(data), ENTRY_SIZE) != ENTRY_SIZE)
+            return false;
+    }
+
+    return file.commit();
+}
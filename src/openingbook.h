@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_OPENINGBOOK_H
+#define KREVERSI_OPENINGBOOK_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/**
+ *  Read-only opening book, mapped into memory from a file.
+ *
+ *  The book knows one move for each of its positions. Positions that are
+ *  the same up to one of the eight symmetries of the board are stored
+ *  only once, under the hash of their canonical form: the one of the
+ *  eight transformed positions whose bitboards compare smallest.
+ *
+ *  The file is a 16 byte header followed by entries sorted by key, all
+ *  numbers in little endian. It is never copied into the process, so all
+ *  programs that use the same book share its pages.
+ *
+ *  @see kreversi-book, which builds a book from game transcripts
+ */
+class OpeningBook
+{
+public:
+    /**
+     *  One position of the book, as stored in the file
+     */
+    struct Entry {
+        /** hash of the canonical position, see key() */
+        quint64 key;
+        /** number of games in which move was played here */
+        quint32 games;
+        /** average final disc difference for the player to move */
+        qint16  score;
+        /** the move, on the canonical board */
+        quint8  move;
+        quint8  reserved;
+    };
+
+    OpeningBook();
+    ~OpeningBook();
+
+    /**
+     *  Maps the book in @p fileName, replacing the one opened before.
+     *  @return @c false if the file can't be read or is not a book
+     */
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const {
+        return m_entries != nullptr;
+    }
+    /**
+     *  @return number of positions in the book
+     */
+    int size() const {
+        return m_size;
+    }
+
+    /**
+     *  @return mask of the book moves for @p player in the position with
+     *  the chips @p player and @p opponent, or 0 if it is not in the book.
+     *  In symmetric positions there is one move for each symmetry.
+     */
+    quint64 moves(quint64 player, quint64 opponent) const;
+
+    /**
+     *  Transforms @p player and @p opponent to their canonical form.
+     *  @return mask with bit s set for each Bitboard::Symmetry s that
+     *  gives that form
+     */
+    static int canonicalize(quint64 &player, quint64 &opponent);
+    /**
+     *  @return key of the position in canonical form @p player, @p opponent
+     */
+    static quint64 key(quint64 player, quint64 opponent);
+
+    /**
+     *  Writes @p entries to a book in @p fileName.
+     *  @return @c false if the file could not be written
+     */
+    static bool save(const QString &fileName, QVector<Entry> entries);
+
+private:
+    const Entry *find(quint64 key) const;
+
+    QFile        m_file;
+    const uchar *m_entries;
+    int          m_size;
+};
+
+#endif
@@ -0,0 +1,298 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "patternevaluator.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+
+#include "bitboard.h"
+
+static const char EVAL_MAGIC[8] = { 'K', 'R', 'V', 'E', 'V', 'A', 'L', '\0' };
+static const quint32 EVAL_VERSION = 1;
+static const int HEADER_SIZE = 16;
+
+// The most patterns a square belongs to
+static const int MAX_SQUARE_PATTERNS = 8;
+
+// The weights that come with KReversi, from eval.qrc. That is part of
+// the kreversi_engine library, whose resources are only registered when
+// asked for, and Q_INIT_RESOURCE() cannot be used inside a namespace.
+static QString evalResource()
+{
+    Q_INIT_RESOURCE(eval);
+    return QStringLiteral(":/kreversi/eval.bin");
+}
+
+namespace
+{
+
+// The squares of one kind of pattern as (row, col), and the symmetries
+// that give its copies on the board.
+struct Shape {
+    int size;
+    int squares[10][2];
+    int copies;
+    int symmetries[8];
+};
+
+const Shape SHAPES[] = {
+    // an edge and the two X-squares next to it
+    { 10, { {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6}, {0, 7}, {1, 1}, {1, 6} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+    // 2x5 block in a corner, along either edge
+    { 10, { {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 1}, {1, 2}, {1, 3}, {1, 4} },
+      8, { Bitboard::Identity, Bitboard::FlipVertical, Bitboard::MirrorHorizontal, Bitboard::Rotate180,
+           Bitboard::FlipDiagonal, Bitboard::FlipAntiDiagonal, Bitboard::Rotate90, Bitboard::Rotate270 } },
+    // 3x3 block in a corner
+    { 9, { {0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+    // the diagonals, from the longest to the shortest one still useful
+    { 8, { {0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6}, {7, 7} },
+      2, { Bitboard::Identity, Bitboard::Rotate90 } },
+    { 7, { {0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 7} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+    { 6, { {0, 2}, {1, 3}, {2, 4}, {3, 5}, {4, 6}, {5, 7} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+    { 5, { {0, 3}, {1, 4}, {2, 5}, {3, 6}, {4, 7} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+    { 4, { {0, 4}, {1, 5}, {2, 6}, {3, 7} },
+      4, { Bitboard::Identity, Bitboard::Rotate90, Bitboard::Rotate180, Bitboard::Rotate270 } },
+};
+
+// Everything derived from SHAPES: where the table of each pattern
+// starts, and which digit of which pattern each square is.
+struct Tables {
+    struct Digit {
+        int     pattern;
+        quint16 power;
+    };
+
+    Tables();
+
+    int     offset[PatternEvaluator::Patterns];
+    Digit   digits[64][MAX_SQUARE_PATTERNS];
+    int     digitCount[64];
+    // index with black and white exchanged, for evaluating for white
+    quint16 swapped[59049];
+};
+
+Tables::Tables()
+{
+    memset(digitCount, 0, sizeof(digitCount));
+
+    int pattern = 0;
+    int tableOffset = 0;
+    for (const Shape &shape : SHAPES) {
+        for (int copy = 0; copy < shape.copies; ++copy) {
+            offset[pattern] = tableOffset;
+
+            quint16 power = 1;
+            for (int i = 0; i < shape.size; ++i) {
+                const quint64 bit = Bitboard::squareBit(Bitboard::square(shape.squares[i][0], shape.squares[i][1]));
+                const int square = Bitboard::firstSquare(Bitboard::transform(bit, shape.symmetries[copy]));
+
+                Q_ASSERT(digitCount[square] < MAX_SQUARE_PATTERNS);
+                digits[square][digitCount[square]++] = { pattern, power };
+                power *= 3;
+            }
+            pattern++;
+        }
+
+        int tableSize = 1;
+        for (int i = 0; i < shape.size; ++i)
+            tableSize *= 3;
+        tableOffset += tableSize;
+    }
+    Q_ASSERT(pattern == PatternEvaluator::Patterns);
+    Q_ASSERT(tableOffset == PatternEvaluator::PhaseSize);
+
+    for (int index = 0; index < 59049; ++index) {
+        int result = 0;
+        for (int rest = index, power = 1; rest; rest /= 3, power *= 3) {
+            if (rest % 3)
+                result += (3 - rest % 3) * power;
+        }
+        swapped[index] = quint16(result);
+    }
+}
+
+const Tables &tables()
+{
+    static const Tables tables;
+    return tables;
+}
+
+QVector<qint16> loadWeights(const QString &fileName)
+{
+    QVector<qint16> weights(PatternEvaluator::Phases * PatternEvaluator::PhaseSize, 0);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open the evaluation weights" << fileName;
+        return weights;
+    }
+
+    const QByteArray data = file.readAll();
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    if (data.size() != HEADER_SIZE + weights.size() * 2
+            || memcmp(bytes, EVAL_MAGIC, sizeof(EVAL_MAGIC)) != 0
+            || qFromLittleEndian<quint32>(bytes + 8) != EVAL_VERSION
+            || qFromLittleEndian<quint32>(bytes + 12) != quint32(PatternEvaluator::Phases)) {
+        qWarning() << "Evaluation weights" << fileName << "are not valid";
+        return weights;
+    }
+
+    for (int i = 0; i < weights.size(); ++i)
+        weights[i] = qFromLittleEndian<qint16>(bytes + HEADER_SIZE + 2 * i);
+    return weights;
+}
+
+// The weights are the same for every engine, so they are only loaded
+// once.
+const QVector<qint16> &weights()
+{
+    static const QVector<qint16> weights = loadWeights(evalResource());
+    return weights;
+}
+
+}
+
+PatternEvaluator::PatternEvaluator()
+    : m_discs(0)
+{
+    // Set up the tables and load the weights with the first evaluator,
+    // rather than in the middle of its first search.
+    tables();
+    weights();
+
+    memset(m_index, 0, sizeof(m_index));
+}
+
+void PatternEvaluator::setup(quint64 black, quint64 white)
+{
+    const Tables &t = tables();
+
+    memset(m_index, 0, sizeof(m_index));
+    for (int square = 0; square < 64; ++square) {
+        const quint64 bit = Bitboard::squareBit(square);
+        const int digit = (black & bit) ? 1 : (white & bit) ? 2 : 0;
+        for (int i = 0; i < t.digitCount[square]; ++i)
+            m_index[t.digits[square][i].pattern] += digit * t.digits[square][i].power;
+    }
+    m_discs = Bitboard::popCount(black | white);
+}
+
+// A black chip is digit 1 and a white one digit 2, so putting down a
+// chip adds its digit, and turning one adds or subtracts 1.  The search
+// calls these for every move it makes, so there is a version for each
+// color, which knows the digits at compile time.
+
+template<ChipColor Color>
+void PatternEvaluator::play(int square, quint64 flips)
+{
+    const Tables &t = tables();
+    const int placed = (Color == Black) ? 1 : 2;
+    const int turned = (Color == Black) ? -1 : 1;
+
+    for (int i = 0; i < t.digitCount[square]; ++i)
+        m_index[t.digits[square][i].pattern] += placed * t.digits[square][i].power;
+
+    for (; flips; flips &= flips - 1) {
+        const int flipped = Bitboard::firstSquare(flips);
+        for (int i = 0; i < t.digitCount[flipped]; ++i)
+            m_index[t.digits[flipped][i].pattern] += turned * t.digits[flipped][i].power;
+    }
+
+    m_discs++;
+}
+
+template<ChipColor Color>
+void PatternEvaluator::undo(int square, quint64 flips)
+{
+    const Tables &t = tables();
+    const int placed = (Color == Black) ? 1 : 2;
+    const int turned = (Color == Black) ? -1 : 1;
+
+    for (int i = 0; i < t.digitCount[square]; ++i)
+        m_index[t.digits[square][i].pattern] -= placed * t.digits[square][i].power;
+
+    for (; flips; flips &= flips - 1) {
+        const int flipped = Bitboard::firstSquare(flips);
+        for (int i = 0; i < t.digitCount[flipped]; ++i)
+            m_index[t.digits[flipped][i].pattern] -= turned * t.digits[flipped][i].power;
+    }
+
+    m_discs--;
+}
+
+// The tables are for black to move, so for white the colors of the
+// index are exchanged.
+
+template<ChipColor ToMove>
+int PatternEvaluator::evaluate() const
+{
+    const Tables &t = tables();
+    const qint16 *w = weights().constData() + phase(m_discs) * PhaseSize;
+
+    int sum = 0;
+    if (ToMove == Black) {
+        for (int pattern = 0; pattern < Patterns; ++pattern)
+            sum += w[t.offset[pattern] + m_index[pattern]];
+    } else {
+        for (int pattern = 0; pattern < Patterns; ++pattern)
+            sum += w[t.offset[pattern] + t.swapped[m_index[pattern]]];
+    }
+    return sum;
+}
+
+template<ChipColor Color>
+int PatternEvaluator::evaluateAfter(int square, quint64 flips) const
+{
+    PatternEvaluator after = *this;
+    after.play<Color>(square, flips);
+    return after.evaluate<(Color == White) ? Black : White>();
+}
+
+template void PatternEvaluator::play<White>(int square, quint64 flips);
+template void PatternEvaluator::play<Black>(int square, quint64 flips);
+template void PatternEvaluator::undo<White>(int square, quint64 flips);
+template void PatternEvaluator::undo<Black>(int square, quint64 flips);
+template int PatternEvaluator::evaluate<White>() const;
+template int PatternEvaluator::evaluate<Black>() const;
+template int PatternEvaluator::evaluateAfter<White>(int square, quint64 flips) const;
+template int PatternEvaluator::evaluateAfter<Black>(int square, quint64 flips) const;
+
+int PatternEvaluator::weightIndex(int pattern, ChipColor toMove) const
+{
+    const Tables &t = tables();
+    const int index = (toMove == Black) ? m_index[pattern] : t.swapped[m_index[pattern]];
+    return t.offset[pattern] + index;
+}
+
+bool PatternEvaluator::save(const QString &fileName, const QVector<qint16> &weights)
+{
+    if (weights.size() != Phases * PhaseSize)
+        return false;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QByteArray data(HEADER_SIZE + weights.size() * 2, '\0');
+    uchar *bytes = reinterpret_cast<uchar *>(data.data());
+    memcpy(bytes, EVAL_MAGIC, sizeof(EVAL_MAGIC));
+    qToLittleEndian<quint32>(EVAL_VERSION, bytes + 8);
+    qToLittleEndian<quint32>(quint32(Phases), bytes + 12);
+    for (int i = 0; i < weights.size(); ++i)
+        qToLittleEndian<qint16>(weights[i], bytes + HEADER_SIZE + 2 * i);
+
+    return file.write(data) == data.size() && file.commit();
+}
@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_PATTERNEVALUATOR_H
+#define KREVERSI_PATTERNEVALUATOR_H
+
+#include <QString>
+#include <QVector>
+
+#include "kreversimove.h"
+
+/**
+ *  Evaluates positions by looking up every edge, corner and diagonal of
+ *  the board in tables of trained weights.
+ *
+ *  A pattern is a fixed list of squares, for example an edge together
+ *  with the two squares diagonally next to its corners. The chips on
+ *  these squares, read as the digits of a number in base 3 (empty,
+ *  black, white), give the index of that configuration in the table of
+ *  the pattern. Symmetric copies of a pattern (the four edges, the
+ *  eight 2x5 corner blocks, ...) share one table, with their squares
+ *  listed in the symmetric order.
+ *
+ *  The tables hold the value of each configuration for the player to
+ *  move, in hundredths of a chip. There is one set of tables for each
+ *  phase of the game, given by the number of chips on the board. The
+ *  weights are compiled into the program (see eval.bin and
+ *  evaltrainer.cpp).
+ *
+ *  The indices of the position being searched are kept up to date while
+ *  moves are made and taken back, so an evaluation costs only one table
+ *  lookup per pattern.
+ */
+class PatternEvaluator
+{
+public:
+    /** Number of game phases with their own weights */
+    static const int Phases = 10;
+    /** Number of patterns on the board, counting symmetric copies */
+    static const int Patterns = 34;
+    /** Number of weights of one phase */
+    static const int PhaseSize = 147582;
+
+    PatternEvaluator();
+
+    /**
+     *  Computes the indices of the position with @p black and @p white
+     *  chips from scratch.
+     */
+    void setup(quint64 black, quint64 white);
+
+    /**
+     *  Updates the indices for @p Color putting a chip on @p square and
+     *  turning the chips of @p flips.
+     */
+    template<ChipColor Color>
+    void play(int square, quint64 flips);
+
+    /**
+     *  Takes back the move given to play().
+     */
+    template<ChipColor Color>
+    void undo(int square, quint64 flips);
+
+    /**
+     *  @return value of the position for @p ToMove, in hundredths of a
+     *  chip
+     */
+    template<ChipColor ToMove>
+    int evaluate() const;
+
+    /**
+     *  @return value of the position after @p Color puts a chip on
+     *  @p square and turns the chips of @p flips, for the opponent of
+     *  @p Color, who is then to move. Faster than play(), evaluate() and
+     *  undo(), since the indices of this evaluator are left alone.
+     */
+    template<ChipColor Color>
+    int evaluateAfter(int square, quint64 flips) const;
+
+    /**
+     *  @return position in the weights of one phase used by @p pattern
+     *  in the current position, when @p toMove is to move
+     */
+    int weightIndex(int pattern, ChipColor toMove) const;
+
+    /**
+     *  @return the phase of a position with @p discs chips on the board
+     */
+    static int phase(int discs) {
+        return qBound(0, (discs - 5) / 6, Phases - 1);
+    }
+
+    /**
+     *  Writes @p weights (Phases times PhaseSize of them) to @p fileName
+     *  in the format of eval.bin.
+     *  @return @c true on success
+     */
+    static bool save(const QString &fileName, const QVector<qint16> &weights);
+
+private:
+    quint16 m_index[Patterns];
+    int     m_discs;
+};
+
+#endif
@@ -0,0 +1,352 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// kreversi-perft: counts the positions a number of moves away from the
+// start position, or from any other, to prove that the move generators
+// are right and to measure how fast they are.
+//
+// A player who cannot move passes, and the pass counts as a move. A
+// finished game counts as one position however many moves are left. From
+// the start position the counts for depth 1 to 11 are 4, 12, 56, 244,
+// 1396, 8200, 55092, 390216, 3005288, 24571284 and 212258800.
+//
+// The positions are counted with the move generator of the engine (see
+// bitboard.h), using the fastest kernels the CPU supports unless --kernels
+// asks for others. With --check the same tree is walked once more with
+// KReversiGame::isMovePossible() and turnChips(), and in every position
+// both must find the same moves, turning the same chips.
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+
+#include "bitboard.h"
+#include "kreversigame.h"
+#include "kreversihumanplayer.h"
+#include "obf.h"
+
+namespace
+{
+
+// Number of positions after one move at the root, or after a pass if
+// square is -1
+struct RootCount {
+    int     square;
+    quint64 nodes;
+};
+
+QString squareName(int square)
+{
+    if (square < 0)
+        return QStringLiteral("pass");
+    return QString(QLatin1Char(char('a' + square % 8))) + QLatin1Char(char('1' + square / 8));
+}
+
+// Count the positions depth moves away, with player to move.  passed
+// tells whether the last move was a pass, so that a second one ends
+// the game.
+quint64 perft(quint64 player, quint64 opponent, int depth, bool passed)
+{
+    if (depth == 0)
+        return 1;
+
+    quint64 moves = Bitboard::legalMoves(player, opponent);
+    if (!moves)
+        return passed ? 1 : perft(opponent, player, depth - 1, true);
+
+    quint64 nodes = 0;
+    for (; moves; moves &= moves - 1) {
+        const int square = Bitboard::firstSquare(moves);
+        const quint64 flips = Bitboard::flips(square, player, opponent);
+        nodes += perft(opponent ^ flips, player ^ flips ^ Bitboard::squareBit(square),
+                       depth - 1, false);
+    }
+    return nodes;
+}
+
+// Same as perft(), with the count after each move at the root.
+QVector<RootCount> divide(quint64 player, quint64 opponent, int depth)
+{
+    QVector<RootCount> counts;
+
+    quint64 moves = Bitboard::legalMoves(player, opponent);
+    if (!moves) {
+        if (Bitboard::legalMoves(opponent, player))
+            counts.append({ -1, perft(opponent, player, depth - 1, true) });
+        return counts;
+    }
+
+    for (; moves; moves &= moves - 1) {
+        const int square = Bitboard::firstSquare(moves);
+        const quint64 flips = Bitboard::flips(square, player, opponent);
+        counts.append({ square, perft(opponent ^ flips, player ^ flips ^ Bitboard::squareBit(square),
+                                      depth - 1, false) });
+    }
+    return counts;
+}
+
+}
+
+// Walks the game tree with the moves of KReversiGame instead, and
+// compares them with the engine in every position.
+
+class KReversiGamePerft
+{
+public:
+    explicit KReversiGamePerft(const Position &position);
+
+    QVector<RootCount> divide(int depth);
+
+    /**
+     *  @return what went wrong if the generators did not agree somewhere
+     */
+    QString error() const {
+        return m_error;
+    }
+
+private:
+    quint64 perft(int depth, bool passed);
+    QVector<int> moves();
+    void play(int square);
+    void takeBack();
+    quint64 chips(ChipColor color) const;
+    QString position() const;
+
+    KReversiHumanPlayer m_black;
+    KReversiHumanPlayer m_white;
+    KReversiGame        m_game;
+    QString             m_error;
+};
+
+KReversiGamePerft::KReversiGamePerft(const Position &position)
+    : m_black(Black, QStringLiteral("Black"))
+    , m_white(White, QStringLiteral("White"))
+    , m_game(&m_black, &m_white)
+{
+    m_game.m_chips[Black] = position.black;
+    m_game.m_chips[White] = position.white;
+    m_game.updateLegalMoves();
+    m_game.m_curPlayer = position.toMove;
+}
+
+QVector<RootCount> KReversiGamePerft::divide(int depth)
+{
+    QVector<RootCount> counts;
+    const ChipColor color = m_game.m_curPlayer;
+
+    const QVector<int> squares = moves();
+    if (squares.isEmpty() && m_error.isEmpty()) {
+        m_game.m_curPlayer = Utils::opponentColorFor(color);
+        if (!moves().isEmpty())
+            counts.append({ -1, perft(depth - 1, true) });
+        m_game.m_curPlayer = color;
+        return counts;
+    }
+
+    for (int square : squares) {
+        play(square);
+        counts.append({ square, perft(depth - 1, false) });
+        takeBack();
+    }
+    return counts;
+}
+
+quint64 KReversiGamePerft::perft(int depth, bool passed)
+{
+    if (depth == 0 || !m_error.isEmpty())
+        return 1;
+
+    const ChipColor color = m_game.m_curPlayer;
+    const QVector<int> squares = moves();
+    quint64 nodes = 0;
+
+    if (squares.isEmpty()) {
+        if (passed)
+            return 1;
+        m_game.m_curPlayer = Utils::opponentColorFor(color);
+        nodes = perft(depth - 1, true);
+        m_game.m_curPlayer = color;
+        return nodes;
+    }
+
+    for (int square : squares) {
+        play(square);
+        nodes += perft(depth - 1, false);
+        takeBack();
+    }
+    return nodes;
+}
+
+// The legal moves of the player to move, checked against the engine.
+
+QVector<int> KReversiGamePerft::moves()
+{
+    const ChipColor color = m_game.m_curPlayer;
+    const quint64 legal = Bitboard::legalMoves(chips(color), chips(Utils::opponentColorFor(color)));
+
+    QVector<int> squares;
+    for (int square = 0; square < 64; ++square) {
+        const bool possible = m_game.isMovePossible(KReversiMove(color, square / 8, square % 8));
+        if (possible != bool(legal & Bitboard::squareBit(square)) && m_error.isEmpty()) {
+            m_error = QStringLiteral("in %1, %2 is %3 for KReversiGame but not for the engine")
+                      .arg(position(), squareName(square),
+                           possible ? QStringLiteral("legal") : QStringLiteral("illegal"));
+        }
+        if (possible)
+            squares.append(square);
+    }
+    return squares;
+}
+
+// Make the move on square, checking the chips turned against the engine.
+
+void KReversiGamePerft::play(int square)
+{
+    const ChipColor color = m_game.m_curPlayer;
+    const KReversiMove move(color, square / 8, square % 8);
+    const quint64 flips = Bitboard::flips(square, chips(color), chips(Utils::opponentColorFor(color)));
+
+    m_game.turnChips(move);
+    m_game.m_curPlayer = Utils::opponentColorFor(color);
+
+    quint64 turned = 0;
+    for (int i = 1; i < m_game.m_changedChips.size(); ++i)
+        turned |= Bitboard::squareBit(Bitboard::square(m_game.m_changedChips[i].row, m_game.m_changedChips[i].col));
+
+    if (turned != flips && m_error.isEmpty()) {
+        // show the position before the move
+        takeBack();
+        m_error = QStringLiteral("in %1, %2 turns other chips for KReversiGame than for the engine")
+                  .arg(position(), squareName(square));
+        m_game.turnChips(move);
+        m_game.m_curPlayer = Utils::opponentColorFor(color);
+    }
+}
+
+// Take back the last move, the same way KReversiGame::undo() does.
+
+void KReversiGamePerft::takeBack()
+{
+    m_game.m_curPlayer = m_game.takeBackPly().color;
+}
+
+quint64 KReversiGamePerft::chips(ChipColor color) const
+{
+    return m_game.position().chips(color);
+}
+
+QString KReversiGamePerft::position() const
+{
+    return Obf::format(m_game.position());
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kreversi-perft"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Counts the positions some moves away to test the KReversi move generators."));
+    parser.addHelpOption();
+    const QCommandLineOption depthOption(QStringList() << QStringLiteral("d") << QStringLiteral("depth"),
+                                         QStringLiteral("Count the positions <moves> moves away."),
+                                         QStringLiteral("moves"), QStringLiteral("8"));
+    const QCommandLineOption positionOption(QStringLiteral("position"),
+                                            QStringLiteral("Start from <position> (.obf line) instead of the start position."),
+                                            QStringLiteral("position"));
+    const QCommandLineOption divideOption(QStringLiteral("divide"),
+                                          QStringLiteral("Show the count after each possible move."));
+    const QCommandLineOption checkOption(QStringLiteral("check"),
+                                         QStringLiteral("Count with KReversiGame as well and compare it with the engine in every position."));
+    parser.addOption(depthOption);
+    parser.addOption(positionOption);
+    parser.addOption(divideOption);
+    QStringList kernelNames;
+    for (const Bitboard::Kernels &kernels : Bitboard::supportedKernels())
+        kernelNames << QLatin1String(kernels.name);
+    const QCommandLineOption kernelsOption(QStringLiteral("kernels"),
+                                           QStringLiteral("Generate the moves with <kernels> instead of the fastest ones (%1).")
+                                           .arg(kernelNames.join(QStringLiteral(", "))),
+                                           QStringLiteral("kernels"));
+    parser.addOption(checkOption);
+    parser.addOption(kernelsOption);
+    parser.process(application);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const int depth = parser.value(depthOption).toInt();
+    if (depth < 1) {
+        err << "The depth must be at least 1\n";
+        return 1;
+    }
+
+    Position position = Position::start();
+    if (parser.isSet(positionOption)) {
+        QString name;
+        QString error;
+        if (!Obf::parse(parser.value(positionOption), position, name, error)) {
+            err << parser.value(positionOption) << ": " << error << '\n';
+            return 1;
+        }
+    }
+
+    if (parser.isSet(kernelsOption)) {
+        const int index = kernelNames.indexOf(parser.value(kernelsOption));
+        if (index < 0) {
+            err << "This CPU cannot run the kernels " << parser.value(kernelsOption) << '\n';
+            return 1;
+        }
+        Bitboard::kernels = Bitboard::supportedKernels().at(index);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<RootCount> counts = divide(position.player(), position.opponent(), depth);
+    const qint64 nsecs = qMax(timer.nsecsElapsed(), qint64(1));
+
+    // A finished game at the root is one position.
+    quint64 nodes = counts.isEmpty() ? 1 : 0;
+    for (const RootCount &count : counts) {
+        nodes += count.nodes;
+        if (parser.isSet(divideOption))
+            out << squareName(count.square) << ' ' << count.nodes << '\n';
+    }
+    out << "depth " << depth << ": " << nodes << " nodes in " << nsecs / 1e6 << " ms, "
+        << qRound64(nodes * 1e9 / nsecs) << " nodes/s with the " << Bitboard::kernels.name << " kernels\n";
+
+    if (!parser.isSet(checkOption))
+        return 0;
+
+    KReversiGamePerft game(position);
+    timer.start();
+    const QVector<RootCount> gameCounts = game.divide(depth);
+    const qint64 gameNsecs = qMax(timer.nsecsElapsed(), qint64(1));
+
+    if (!game.error().isEmpty()) {
+        err << "The move generators disagree: " << game.error() << '\n';
+        return 1;
+    }
+
+    quint64 gameNodes = gameCounts.isEmpty() ? 1 : 0;
+    bool same = (gameCounts.size() == counts.size());
+    for (int i = 0; i < gameCounts.size(); ++i) {
+        gameNodes += gameCounts[i].nodes;
+        same = same && gameCounts[i].square == counts[i].square && gameCounts[i].nodes == counts[i].nodes;
+    }
+    out << "KReversiGame: " << gameNodes << " nodes in " << gameNsecs / 1e6 << " ms, "
+        << qRound64(gameNodes * 1e9 / gameNsecs) << " nodes/s\n";
+
+    if (!same) {
+        err << "The counts of the engine and of KReversiGame differ\n";
+        return 1;
+    }
+    out << "The move generators agree\n";
+    return 0;
+}
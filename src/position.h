@@ -0,0 +1,115 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_POSITION_H
+#define KREVERSI_POSITION_H
+
+#include <QHash>
+#include <QtGlobal>
+
+#include "bitboard.h"
+#include "kreversimove.h"
+
+/**
+ *  A position as the engine sees it: the chips of each player as a
+ *  bitboard (see Bitboard) and the player to move.
+ *
+ *  This is all the engine needs to know about a game, so anything that
+ *  can describe a board this way can use the engine without depending
+ *  on KReversiGame.
+ */
+struct Position {
+    quint64   black = 0;
+    quint64   white = 0;
+    ChipColor toMove = Black;
+
+    /**
+     *  @return the position at the start of a game
+     */
+    static Position start() {
+        Position position;
+        position.black = Bitboard::squareBit(Bitboard::square(3, 4)) | Bitboard::squareBit(Bitboard::square(4, 3));
+        position.white = Bitboard::squareBit(Bitboard::square(3, 3)) | Bitboard::squareBit(Bitboard::square(4, 4));
+        return position;
+    }
+
+    /**
+     *  @return the chips of @p color, or the empty squares for @c NoColor
+     */
+    quint64 chips(ChipColor color) const {
+        if (color == Black)
+            return black;
+        if (color == White)
+            return white;
+        return ~(black | white);
+    }
+
+    /**
+     *  @return the chips of the player to move
+     */
+    quint64 player() const {
+        return chips(toMove);
+    }
+
+    /**
+     *  @return the chips of the other player
+     */
+    quint64 opponent() const {
+        return chips(Utils::opponentColorFor(toMove));
+    }
+
+    /**
+     *  @return color of the chip on @p square, see Bitboard::square()
+     */
+    ChipColor chipColorAt(int square) const {
+        if (black & Bitboard::squareBit(square))
+            return Black;
+        if (white & Bitboard::squareBit(square))
+            return White;
+        return NoColor;
+    }
+
+    /**
+     *  Puts a chip of @p color on @p square, or removes the chip there
+     *  for @c NoColor.
+     */
+    void setChipColor(int square, ChipColor color) {
+        const quint64 bit = Bitboard::squareBit(square);
+        black = (color == Black) ? (black | bit) : (black & ~bit);
+        white = (color == White) ? (white | bit) : (white & ~bit);
+    }
+
+    /**
+     *  Puts a chip of the player to move on @p square, turns the chips
+     *  it captures and gives the turn to the other player. The move must
+     *  be legal.
+     */
+    void play(int square) {
+        const quint64 flips = Bitboard::flips(square, player(), opponent());
+        if (toMove == Black) {
+            black ^= flips | Bitboard::squareBit(square);
+            white ^= flips;
+        } else {
+            white ^= flips | Bitboard::squareBit(square);
+            black ^= flips;
+        }
+        toMove = Utils::opponentColorFor(toMove);
+    }
+
+    bool operator==(const Position &other) const {
+        return black == other.black && white == other.white && toMove == other.toMove;
+    }
+    bool operator!=(const Position &other) const {
+        return !(*this == other);
+    }
+};
+
+inline uint qHash(const Position &position, uint seed = 0)
+{
+    return qHash(position.black ^ (position.white * 0x9e3779b97f4a7c15ULL), seed) ^ uint(position.toMove);
+}
+
+#endif
@@ -35,61 +35,6 @@ Item {
       */
     signal cellClicked(int row, int column)
 
-    /**
-      * Enables/disables hint at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show hint
-      *              @c false hide hint
-      */
-    function setHint(row, column, value) {
-        cells.itemAt(row * Globals.COLUMN_COUNT + column).isHint = value
-    }
-
-    /**
-      * Enables/disables legal marker at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show legal marker
-      *              @c false hide legal marker
-      */
-    function setLegal(row, column, value) {
-        cells.itemAt(row * Globals.COLUMN_COUNT + column).isLegal = value
-    }
-
-    /**
-      * Turn chip to White/Black at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c "Black" turn chip to black
-      *              @c "White turn chip to white
-      *              @c "" (empty string) hide chip
-      */
-    function setChipState(row, column, value) {
-        cells.itemAt(row * Globals.COLUMN_COUNT + column).chipState = value
-    }
-
-    /**
-      * Enables/disables last move marker at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show last move marker
-      *              @c false hide last move marker
-      */
-    function setLastMove(row, column, value) {
-        cells.itemAt(row * Globals.COLUMN_COUNT + column).isLastMove = value
-    }
-    
-    /**
-     * Sets time to wait before starting animation
-     * @param row row index of cell (starting from 0)
-     * @param column column index of cell (starting from 0)
-     * @param value time to wait
-     */
-    function setPreAnimationTime(row, column, value) {
-        cells.itemAt(row * Globals.COLUMN_COUNT + column).chipPreAnimationTime = value
-    }
-
     CanvasItem {
         id: boardLabels
         anchors.fill: parent
@@ -109,7 +54,8 @@ Item {
 
         Repeater {
             id: cells
-            model: Globals.ROW_COUNT * Globals.COLUMN_COUNT
+            // one row per cell, see KReversiBoardModel
+            model: boardModel
 
             Cell {
                 x: (index % Globals.COLUMN_COUNT)
@@ -126,6 +72,12 @@ Item {
                 height: Globals.GRID_HEIGHT_PERCENT * boardContainer.height
                         / Globals.ROW_COUNT
 
+                chipState: model.chipState
+                isLegal: model.isLegal
+                isHint: model.isHint
+                isLastMove: model.isLastMove
+                chipPreAnimationTime: model.preAnimationTime
+
                 chipImagePrefix: boardContainer.chipsImagePrefix
                 chipAnimationTime: boardContainer.chipsAnimationTime
 
@@ -34,56 +34,6 @@ Item {
       * @param column column index of cell (starting from 0)
       */
     signal cellClicked(int row, int column)
-    /**
-      * Enables/disables legal marker at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show legal marker
-      *              @c false hide legal marker
-      */
-    function setLegal(row, column, value) {
-        board.setLegal(row, column, value);
-    }
-    /**
-      * Turn chip to White/Black at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c "Black" turn chip to black
-      *              @c "White turn chip to white
-      *              @c "" (empty string) hide chip
-      */
-    function setChipState(row, column, value) {
-        board.setChipState(row, column, value);
-    }
-    /**
-      * Enables/disables hint at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show hint
-      *              @c false hide hint
-      */
-    function setHint(row, col, show) {
-        board.setHint(row, col, show);
-    }
-    /**
-      * Enables/disables last move marker at (row, column) cell
-      * @param row row index of cell (starting from 0)
-      * @param column column index of cell (starting from 0)
-      * @param value @c true show last move marker
-      *              @c false hide last move marker
-      */
-    function setLastMove(row, column, value) {
-        board.setLastMove(row, column, value)
-    }
-    /**
-     * Sets time to wait before starting animation
-     * @param row row index of cell (starting from 0)
-     * @param column column index of cell (starting from 0)
-     * @param value time to wait
-     */
-    function setPreAnimationTime(row, column, value) {
-        board.setPreAnimationTime(row, column, value);
-    }
     /**
       * Shows popup with specified text
       * @param text Text to show
@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "transcript.h"
+
+#include <QRegularExpression>
+
+#include "bitboard.h"
+
+bool Transcript::parse(const QString &line, Game &game, QString &error)
+{
+    static const QRegularExpression movesPattern(QStringLiteral("^(([a-h][1-8])\\s*)+"),
+                                                 QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression resultPattern(QStringLiteral("^[+-]?\\d+$"));
+
+    const QString text = line.trimmed();
+    const QRegularExpressionMatch match = movesPattern.match(text);
+    if (!match.hasMatch()) {
+        error = QStringLiteral("no moves found");
+        return false;
+    }
+
+    const QString moves = match.captured(0).remove(QRegularExpression(QStringLiteral("\\s"))).toLower();
+    for (int i = 0; i < moves.size(); i += 2)
+        game.moves.append(Bitboard::square(moves[i + 1].toLatin1() - '1', moves[i].toLatin1() - 'a'));
+
+    const QString rest = text.mid(match.capturedLength()).trimmed();
+    bool hasResult = false;
+    if (!rest.isEmpty()) {
+        if (!resultPattern.match(rest).hasMatch()) {
+            error = QStringLiteral("cannot read result \"%1\"").arg(rest);
+            return false;
+        }
+        game.result = rest.toInt();
+        hasResult = true;
+    }
+
+    // Replay the game to check the moves and, if needed, to count the
+    // discs at the end.
+    quint64 player = Bitboard::squareBit(Bitboard::square(3, 4)) | Bitboard::squareBit(Bitboard::square(4, 3));
+    quint64 opponent = Bitboard::squareBit(Bitboard::square(3, 3)) | Bitboard::squareBit(Bitboard::square(4, 4));
+    bool blackToMove = true;
+
+    for (int i = 0; i < game.moves.size(); ++i) {
+        if (!Bitboard::legalMoves(player, opponent)) {
+            qSwap(player, opponent);
+            blackToMove = !blackToMove;
+        }
+        // flips() does not look at the square itself, so a move onto a
+        // disc could turn some and corrupt the position
+        if (!(Bitboard::squareBit(game.moves[i]) & Bitboard::legalMoves(player, opponent))) {
+            error = QStringLiteral("illegal move %1").arg(i + 1);
+            return false;
+        }
+        const quint64 flips = Bitboard::flips(game.moves[i], player, opponent);
+        player ^= flips | Bitboard::squareBit(game.moves[i]);
+        opponent ^= flips;
+        qSwap(player, opponent);
+        blackToMove = !blackToMove;
+    }
+
+    if (!hasResult) {
+        if (Bitboard::legalMoves(player, opponent) || Bitboard::legalMoves(opponent, player)) {
+            error = QStringLiteral("game is not finished and has no result");
+            return false;
+        }
+        const int difference = Bitboard::popCount(player) - Bitboard::popCount(opponent);
+        game.result = blackToMove ? difference : -difference;
+    }
+
+    return true;
+}
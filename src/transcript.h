@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_TRANSCRIPT_H
+#define KREVERSI_TRANSCRIPT_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ *  Reading the game transcripts used to build the opening book and to
+ *  train the evaluation.
+ *
+ *  Each line of a transcript file is one game: its moves written as
+ *  column letter and row number ("f5d6c3d3c4..."), optionally separated
+ *  by spaces, followed by the final disc difference for black ("+12",
+ *  "-4", "0"). The result may be left out for games that were played to
+ *  the end. Empty lines and lines starting with '#' are skipped by the
+ *  tools.
+ */
+namespace Transcript
+{
+struct Game {
+    /** The squares played, see Bitboard::square() */
+    QVector<int> moves;
+    /** Final disc difference for black */
+    int result = 0;
+};
+
+/**
+ *  Parses one transcript line into @p game.
+ *  @return @c false with a message in @p error if it is not a valid game
+ */
+bool parse(const QString &line, Game &game, QString &error);
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "transpositiontable.h"
+
+TranspositionTable::TranspositionTable()
+    : m_mask(0), m_generation(0)
+{
+}
+
+void TranspositionTable::resize(int megabytes)
+{
+    // round the number of entries down to a power of two, so that the
+    // slot of a key is simply its lowest bits
+    const quint64 wanted = quint64(qMax(megabytes, 0)) * 1024 * 1024 / sizeof(Slot);
+    quint64 count = 1;
+    while (count * 2 <= wanted)
+        count *= 2;
+
+    m_slots.reset();
+    m_mask = 0;
+    if (wanted == 0)
+        return;
+
+    m_slots.reset(new Slot[count]);
+    m_mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    if (!m_slots)
+        return;
+
+    // an empty slot must not match key 0, so its check word is made to
+    // disagree with its data word
+    const Entry empty = { 0, 0, -1, Exact, -1, 0 };
+    const quint64 data = pack(empty);
+    for (quint64 i = 0; i <= m_mask; ++i) {
+        m_slots[i].data.store(data, std::memory_order_relaxed);
+        m_slots[i].check.store(~data, std::memory_order_relaxed);
+    }
+}
+
+void TranspositionTable::store(quint64 key, int depth, Bound bound, int score, int move)
+{
+    if (!m_slots)
+        return;
+
+    Slot &slot = m_slots[key & m_mask];
+
+    const quint8 generation = m_generation.load(std::memory_order_relaxed);
+
+    Entry entry;
+    if (read(slot, key, entry)) {
+        // a shallower result of the current search, such as one of a
+        // helper a step behind, only replaces a deeper bound if it is exact
+        if (entry.generation == generation && entry.depth > depth
+                && (bound != Exact || entry.bound == Exact))
+            return;
+        // don't lose the best move of a position when its new result has none
+        if (move < 0)
+            move = entry.move;
+    } else {
+        // keep deeper results of the current search
+        const quint64 data = slot.data.load(std::memory_order_relaxed);
+        if (quint8(data >> 56) == generation && qint8(data >> 32) > depth)
+            return;
+    }
+
+    entry.key        = key;
+    entry.score      = score;
+    entry.depth      = qint8(depth);
+    entry.bound      = quint8(bound);
+    entry.move       = qint8(move);
+    entry.generation = generation;
+
+    const quint64 data = pack(entry);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+quint64 TranspositionTable::pack(const Entry &entry)
+{
+    return quint64(quint32(entry.score))
+           | quint64(quint8(entry.depth)) << 32
+           | quint64(entry.bound) << 40
+           | quint64(quint8(entry.move)) << 48
+           | quint64(entry.generation) << 56;
+}
+
+bool TranspositionTable::read(const Slot &slot, quint64 key, Entry &entry)
+{
+    const quint64 data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) != key)
+        return false;
+
+    entry.key        = key;
+    entry.score      = qint32(quint32(data));
+    entry.depth      = qint8(data >> 32);
+    entry.bound      = quint8(data >> 40);
+    entry.move       = qint8(data >> 48);
+    entry.generation = quint8(data >> 56);
+    return true;
+}
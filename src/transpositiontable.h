@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 The KReversi Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KREVERSI_TRANSPOSITIONTABLE_H
+#define KREVERSI_TRANSPOSITIONTABLE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+/**
+ *  Fixed-size hash table remembering search results by position.
+ *
+ *  Positions are identified by a 64 bit Zobrist hash which Engine keeps
+ *  up to date while making moves. Each slot holds one entry, and a new
+ *  result replaces the old one unless the old one is from the current
+ *  search and was searched deeper.
+ *
+ *  Several search threads may use the table at the same time without
+ *  locking. A slot holds the result packed into one 64 bit word plus
+ *  the key XORed with that word. When two threads write the same slot at
+ *  once a reader may see the word of one and the key of the other, but
+ *  then the XOR no longer gives the key that is looked for and the slot
+ *  is treated as empty.
+ */
+class TranspositionTable
+{
+public:
+    /**
+     *  How the stored score relates to the real value of the position
+     */
+    enum Bound {
+        /** Score is exact */
+        Exact,
+        /** Real value is at least score (search failed high) */
+        Lower,
+        /** Real value is at most score (search failed low) */
+        Upper
+    };
+
+    struct Entry {
+        quint64 key;
+        qint32  score;
+        qint8   depth;
+        quint8  bound;
+        qint8   move;
+        quint8  generation;
+    };
+
+    TranspositionTable();
+
+    /**
+     *  Reallocates the table to use about @p megabytes of memory.
+     *  All stored entries are lost. No search may use the table meanwhile.
+     */
+    void resize(int megabytes);
+
+    /**
+     *  Forgets all stored entries. No search may use the table meanwhile.
+     */
+    void clear();
+
+    /**
+     *  Marks the start of a new search. Entries from older searches are
+     *  replaced first. May be called while other searches use the table.
+     */
+    void newSearch() {
+        m_generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     *  Looks up @p key.
+     *  @return @c true and fills @p entry if the position is stored
+     */
+    bool probe(quint64 key, Entry &entry) const {
+        if (!m_slots)
+            return false;
+        return read(m_slots[key & m_mask], key, entry);
+    }
+
+    /**
+     *  Stores the result of searching the position @p key to @p depth.
+     *  A deeper result of the current search is kept, unless the new one
+     *  is exact and the stored one is only a bound.
+     */
+    void store(quint64 key, int depth, Bound bound, int score, int move);
+
+private:
+    struct Slot {
+        std::atomic<quint64> check;
+        std::atomic<quint64> data;
+    };
+
+    static quint64 pack(const Entry &entry);
+    static bool read(const Slot &slot, quint64 key, Entry &entry);
+
+    std::unique_ptr<Slot[]> m_slots;
+    quint64                 m_mask;
+    // changed by any engine sharing the table when it starts a search,
+    // while the others go on reading it
+    std::atomic<quint8>     m_generation;
+};
+
+#endif